@@ -0,0 +1,57 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// C++20 named module for units.h. The header is parsed once when the 
+// module is built, importers only load the compiled module interface.
+//
+// NOTE(thinks):
+//   Ideally only the public interface would be exported, using 
+//   using-declarations in an exported namespace. Compilers that currently 
+//   support modules (e.g. GCC 12) do not reliably export entities from the 
+//   global module fragment that way, hence the header is exported as a 
+//   whole. Implementation details remain in the units_internal namespace.
+//
+//   Modules do not export macros, code that registers user-defined tags,
+//   scales or suffixes (THINKS_UNITS_* macros) must include the header.
+//   A translation unit should not both include the header and import the 
+//   module.
+
+module;
+
+// Standard headers used by units.h, these stay in the global module.
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <ratio>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module thinks.units;
+
+export {
+#include "thinks/units/units.h"
+}
@@ -0,0 +1,169 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Algorithms on units with potentially different scales.
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+namespace units_internal {
+
+// Largest scale that both scales are integer multiples of, such that 
+// conversions into it are exact for rational scales (cf. std::chrono).
+// If the scales have different powers of pi there is no such scale, 
+// the scale with the power of pi closest to zero is used (e.g. degrees 
+// rather than radians), favoring the first scale on ties.
+template <typename Scale1T, typename Scale2T>
+struct CommonScaleImpl {
+  using Ratio1T = typename ScaleTraits<Scale1T>::RatioType;
+  using Ratio2T = typename ScaleTraits<Scale2T>::RatioType;
+  static constexpr int kPiExponent1 = ScaleTraits<Scale1T>::pi_exponent;
+  static constexpr int kPiExponent2 = ScaleTraits<Scale2T>::pi_exponent;
+  static constexpr std::intmax_t kDenGcd = Gcd(Ratio1T::den, Ratio2T::den);
+
+  using type = std::conditional_t<
+      kPiExponent1 == kPiExponent2,
+      MakeScale<typename std::ratio<Gcd(Ratio1T::num, Ratio2T::num),
+                                    (Ratio1T::den / kDenGcd) *
+                                        Ratio2T::den>::type,
+                kPiExponent1>,
+      std::conditional_t<((kPiExponent1 < 0 ? -kPiExponent1 : kPiExponent1) <=
+                          (kPiExponent2 < 0 ? -kPiExponent2 : kPiExponent2)),
+                         Scale1T, Scale2T>>;
+};
+
+}  // namespace units_internal
+
+// Unit that values of all the given same-tag units can be converted into 
+// without loss of precision, as far as possible. The value type follows 
+// normal arithmetic promotion.
+template <typename... UnitTs>
+struct common_unit;
+template <typename ArithT, typename ScaleT, typename TagT>
+struct common_unit<Unit<ArithT, ScaleT, TagT>> {
+  using type = Unit<ArithT, ScaleT, TagT>;
+};
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+struct common_unit<Unit<ArithT1, ScaleT1, TagT>, Unit<ArithT2, ScaleT2, TagT>> {
+  using type = 
+      Unit<std::common_type_t<ArithT1, ArithT2>,
+           typename units_internal::CommonScaleImpl<ScaleT1, ScaleT2>::type, 
+           TagT>;
+};
+template <typename UnitT1, typename UnitT2, typename UnitT3, 
+          typename... UnitTs>
+struct common_unit<UnitT1, UnitT2, UnitT3, UnitTs...>
+    : common_unit<typename common_unit<UnitT1, UnitT2>::type, UnitT3,
+                  UnitTs...> {};
+
+template <typename... UnitTs>
+using common_unit_t = typename common_unit<UnitTs...>::type;
+
+// Minimum, maximum and clamping of same-tag units with potentially 
+// different scales and value types. Each operand is converted exactly once, 
+// into the common unit, which is also the return type. Ties return the 
+// first argument, like the std versions.
+//
+// clang-format off
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto min(const Unit<ArithT1, ScaleT1, TagT> a,
+                   const Unit<ArithT2, ScaleT2, TagT> b) 
+    -> common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                     Unit<ArithT2, ScaleT2, TagT>> {
+  using CommonT = common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                                Unit<ArithT2, ScaleT2, TagT>>;
+  const auto ca = unit_cast<CommonT>(a);
+  const auto cb = unit_cast<CommonT>(b);
+  return cb.value() < ca.value() ? cb : ca;
+}
+
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto max(const Unit<ArithT1, ScaleT1, TagT> a,
+                   const Unit<ArithT2, ScaleT2, TagT> b) 
+    -> common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                     Unit<ArithT2, ScaleT2, TagT>> {
+  using CommonT = common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                                Unit<ArithT2, ScaleT2, TagT>>;
+  const auto ca = unit_cast<CommonT>(a);
+  const auto cb = unit_cast<CommonT>(b);
+  return ca.value() < cb.value() ? cb : ca;
+}
+
+// The behavior is undefined if hi is less than lo.
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, 
+          typename ArithT3, typename ScaleT3, typename TagT>
+NO_DISCARD
+constexpr auto clamp(const Unit<ArithT1, ScaleT1, TagT> v,
+                     const Unit<ArithT2, ScaleT2, TagT> lo,
+                     const Unit<ArithT3, ScaleT3, TagT> hi) 
+    -> common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                     Unit<ArithT2, ScaleT2, TagT>,
+                     Unit<ArithT3, ScaleT3, TagT>> {
+  using CommonT = common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                                Unit<ArithT2, ScaleT2, TagT>,
+                                Unit<ArithT3, ScaleT3, TagT>>;
+  const auto cv = unit_cast<CommonT>(v);
+  const auto clo = unit_cast<CommonT>(lo);
+  const auto chi = unit_cast<CommonT>(hi);
+  return cv.value() < clo.value() ? clo 
+                                  : chi.value() < cv.value() ? chi : cv;
+}
+
+// Length of the vector with the given components, without undue overflow
+// or underflow (see std::hypot). The value type is floating point.
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+auto hypot(const Unit<ArithT1, ScaleT1, TagT> x,
+           const Unit<ArithT2, ScaleT2, TagT> y) {
+  using CommonT = common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                                Unit<ArithT2, ScaleT2, TagT>>;
+  using ValueT = decltype(std::hypot(typename CommonT::ValueType{}, 
+                                     typename CommonT::ValueType{}));
+  return Unit<ValueT, typename CommonT::ScaleType, TagT>{
+      std::hypot(unit_cast<CommonT>(x).value(), 
+                 unit_cast<CommonT>(y).value())};
+}
+
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, 
+          typename ArithT3, typename ScaleT3, typename TagT>
+NO_DISCARD
+auto hypot(const Unit<ArithT1, ScaleT1, TagT> x,
+           const Unit<ArithT2, ScaleT2, TagT> y,
+           const Unit<ArithT3, ScaleT3, TagT> z) {
+  using CommonT = common_unit_t<Unit<ArithT1, ScaleT1, TagT>, 
+                                Unit<ArithT2, ScaleT2, TagT>,
+                                Unit<ArithT3, ScaleT3, TagT>>;
+  using ValueT = decltype(std::hypot(typename CommonT::ValueType{}, 
+                                     typename CommonT::ValueType{},
+                                     typename CommonT::ValueType{}));
+  return Unit<ValueT, typename CommonT::ScaleType, TagT>{
+      std::hypot(unit_cast<CommonT>(x).value(), 
+                 unit_cast<CommonT>(y).value(),
+                 unit_cast<CommonT>(z).value())};
+}
+// clang-format on
+
+#undef NO_DISCARD
+
+}  // namespace thinks
@@ -0,0 +1,222 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Atomic operations on units, e.g. for accumulating into shared grids.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+namespace units_internal {
+
+// Atomically add a value, std::atomic only supports fetch_add for
+// floating point types from C++20. The compare-exchange loop is
+// lock-free whenever the underlying atomic is.
+template <typename AtomicT, typename ArithT>
+auto AtomicFetchAdd(AtomicT& a, const ArithT v,
+                    const std::memory_order order) noexcept -> ArithT {
+#if defined(__cpp_lib_atomic_float)
+  return a.fetch_add(v, order);
+#else
+  if constexpr (std::is_integral_v<ArithT>) {
+    return a.fetch_add(v, order);
+  } else {
+    auto expected = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(expected, expected + v, order,
+                                    std::memory_order_relaxed)) {
+    }
+    return expected;
+  }
+#endif
+}
+
+// Storage of a unit value, a unit is standard layout with the value as
+// its only member, such that the two are pointer-interconvertible.
+template <typename UnitT>
+NO_DISCARD auto ValueRef(UnitT& u) noexcept -> typename UnitT::ValueType& {
+  static_assert(std::is_standard_layout_v<UnitT> &&
+                    sizeof(UnitT) == sizeof(typename UnitT::ValueType),
+                "unit must have the same layout as its value type");
+  return *reinterpret_cast<typename UnitT::ValueType*>(&u);
+}
+
+}  // namespace units_internal
+
+// Atomic unit. Units with the same tag but different scales can be added
+// and subtracted, the operand is converted to the scale of the atomic
+// unit (once) before the atomic operation.
+//
+// NOTE(thinks):
+//   A separate class rather than a specialization of std::atomic, since
+//   std::atomic<Unit<...>> would only provide load/store/exchange.
+template <typename UnitT>
+class AtomicUnit;
+template <typename ArithT, typename ScaleT, typename TagT>
+class AtomicUnit<Unit<ArithT, ScaleT, TagT>> {
+ public:
+  using UnitType = Unit<ArithT, ScaleT, TagT>;
+  using ValueType = ArithT;
+
+  static constexpr bool is_always_lock_free =
+      std::atomic<ArithT>::is_always_lock_free;
+
+  constexpr AtomicUnit() noexcept : value_{ArithT{0}} {}
+  constexpr AtomicUnit(const UnitType u) noexcept : value_{u.value()} {}
+  AtomicUnit(const AtomicUnit&) = delete;
+  AtomicUnit& operator=(const AtomicUnit&) = delete;
+
+  NO_DISCARD bool is_lock_free() const noexcept {
+    return value_.is_lock_free();
+  }
+
+  NO_DISCARD auto load(const std::memory_order order =
+                           std::memory_order_seq_cst) const noexcept
+      -> UnitType {
+    return UnitType{value_.load(order)};
+  }
+
+  void store(const UnitType u, const std::memory_order order =
+                                   std::memory_order_seq_cst) noexcept {
+    value_.store(u.value(), order);
+  }
+
+  auto exchange(const UnitType u, const std::memory_order order =
+                                      std::memory_order_seq_cst) noexcept
+      -> UnitType {
+    return UnitType{value_.exchange(u.value(), order)};
+  }
+
+  auto compare_exchange_weak(UnitType& expected, const UnitType desired,
+                             const std::memory_order order =
+                                 std::memory_order_seq_cst) noexcept -> bool {
+    auto& e = units_internal::ValueRef(expected);
+    return value_.compare_exchange_weak(e, desired.value(), order);
+  }
+
+  auto compare_exchange_strong(UnitType& expected, const UnitType desired,
+                               const std::memory_order order =
+                                   std::memory_order_seq_cst) noexcept
+      -> bool {
+    auto& e = units_internal::ValueRef(expected);
+    return value_.compare_exchange_strong(e, desired.value(), order);
+  }
+
+  // Returns the value before the addition, in the scale of this unit.
+  template <typename ArithT2, typename ScaleT2>
+  auto fetch_add(const Unit<ArithT2, ScaleT2, TagT> rhs,
+                 const std::memory_order order =
+                     std::memory_order_seq_cst) -> UnitType {
+    return UnitType{units_internal::AtomicFetchAdd(
+        value_, unit_cast<UnitType>(rhs).value(), order)};
+  }
+
+  // Returns the value before the subtraction, in the scale of this unit.
+  template <typename ArithT2, typename ScaleT2>
+  auto fetch_sub(const Unit<ArithT2, ScaleT2, TagT> rhs,
+                 const std::memory_order order =
+                     std::memory_order_seq_cst) -> UnitType {
+    return UnitType{units_internal::AtomicFetchAdd(
+        value_, static_cast<ArithT>(-unit_cast<UnitType>(rhs).value()),
+        order)};
+  }
+
+  // clang-format off
+  template <typename ArithT2, typename ScaleT2>
+  auto operator+=(const Unit<ArithT2, ScaleT2, TagT> rhs)
+      -> UnitType {
+    const auto v = unit_cast<UnitType>(rhs).value();
+    return UnitType{static_cast<ArithT>(
+        units_internal::AtomicFetchAdd(value_, v, std::memory_order_seq_cst) + v)};
+  }
+
+  template <typename ArithT2, typename ScaleT2>
+  auto operator-=(const Unit<ArithT2, ScaleT2, TagT> rhs)
+      -> UnitType {
+    const auto v = static_cast<ArithT>(-unit_cast<UnitType>(rhs).value());
+    return UnitType{static_cast<ArithT>(
+        units_internal::AtomicFetchAdd(value_, v, std::memory_order_seq_cst) + v)};
+  }
+  // clang-format on
+
+  NO_DISCARD operator UnitType() const noexcept { return load(); }
+
+ private:
+  std::atomic<ArithT> value_;
+};
+
+#if defined(__cpp_lib_atomic_ref)
+// Atomic operations on a unit that is not itself atomic, e.g. the voxels
+// of a dose grid that is only updated concurrently during some phases.
+// While any AtomicUnitRef to a unit exists, the unit must only be
+// accessed through AtomicUnitRef instances.
+template <typename UnitT>
+class AtomicUnitRef;
+template <typename ArithT, typename ScaleT, typename TagT>
+class AtomicUnitRef<Unit<ArithT, ScaleT, TagT>> {
+ public:
+  using UnitType = Unit<ArithT, ScaleT, TagT>;
+  using ValueType = ArithT;
+
+  static constexpr bool is_always_lock_free =
+      std::atomic_ref<ArithT>::is_always_lock_free;
+  static constexpr std::size_t required_alignment =
+      std::atomic_ref<ArithT>::required_alignment;
+
+  explicit AtomicUnitRef(UnitType& u) noexcept
+      : value_{units_internal::ValueRef(u)} {}
+
+  NO_DISCARD bool is_lock_free() const noexcept {
+    return value_.is_lock_free();
+  }
+
+  NO_DISCARD auto load(const std::memory_order order =
+                           std::memory_order_seq_cst) const noexcept
+      -> UnitType {
+    return UnitType{value_.load(order)};
+  }
+
+  void store(const UnitType u, const std::memory_order order =
+                                   std::memory_order_seq_cst) const noexcept {
+    value_.store(u.value(), order);
+  }
+
+  // Returns the value before the addition, in the scale of the unit.
+  template <typename ArithT2, typename ScaleT2>
+  auto fetch_add(const Unit<ArithT2, ScaleT2, TagT> rhs,
+                 const std::memory_order order =
+                     std::memory_order_seq_cst) const -> UnitType {
+    return UnitType{units_internal::AtomicFetchAdd(
+        value_, unit_cast<UnitType>(rhs).value(), order)};
+  }
+
+  // Returns the value before the subtraction, in the scale of the unit.
+  template <typename ArithT2, typename ScaleT2>
+  auto fetch_sub(const Unit<ArithT2, ScaleT2, TagT> rhs,
+                 const std::memory_order order =
+                     std::memory_order_seq_cst) const -> UnitType {
+    return UnitType{units_internal::AtomicFetchAdd(
+        value_, static_cast<ArithT>(-unit_cast<UnitType>(rhs).value()),
+        order)};
+  }
+
+ private:
+  std::atomic_ref<ArithT> value_;
+};
+#endif  // defined(__cpp_lib_atomic_ref)
+
+#undef NO_DISCARD
+
+}  // namespace thinks
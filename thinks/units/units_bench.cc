@@ -0,0 +1,740 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thinks/units/units.h"
+
+namespace {
+
+// Time a callable, returns elapsed seconds.
+template <typename F>
+double Seconds(F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(t1 - t0).count();
+}
+
+// Synthetic telemetry log with lines like "123.45 [deg] 0.0123 [Gy]".
+std::string MakeTelemetryLog(const std::size_t bytes) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> angle(0.f, 360.f);
+  std::uniform_real_distribution<float> dose(0.f, 0.05f);
+  std::string log;
+  log.reserve(bytes + 64);
+  char line[64];
+  while (log.size() < bytes) {
+    const int n = std::snprintf(line, sizeof(line), "%.2f [deg] %.4f [Gy]\n",
+                                angle(rng), dose(rng));
+    log.append(line, static_cast<std::size_t>(n));
+  }
+  return log;
+}
+
+void BenchParseLines(const std::size_t bytes) {
+  const auto log = MakeTelemetryLog(bytes);
+  const auto lines = static_cast<std::size_t>(
+      std::count(log.begin(), log.end(), '\n'));
+  std::vector<thinks::Degrees<float>> gantry(lines, 0.f);
+  std::vector<thinks::Gray<float>> dose(lines, 0.f);
+
+  thinks::ParseLinesResult r = {};
+  const auto s = Seconds([&]() {
+    r = thinks::parse_lines(log.data(), log.data() + log.size(), lines,
+                            gantry.data(), dose.data());
+  });
+  if (r.ec != std::errc{} || r.count != lines) {
+    std::fprintf(stderr, "parse_lines failed\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("parse_lines: %zu lines, %.1f MB in %.3f s: %.1f MB/s, %.1f M lines/s\n",
+              lines, log.size() / 1e6, s, log.size() / 1e6 / s,
+              lines / 1e6 / s);
+}
+
+// Slowly varying gantry angle telemetry, [1/100 deg].
+void BenchDeltaCodec(const std::size_t count) {
+  using UnitT = thinks::Degrees<std::int32_t>;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<std::int32_t> step(-20, 20);
+  std::vector<UnitT> angles;
+  angles.reserve(count);
+  std::int32_t a = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    a += step(rng);
+    angles.push_back(UnitT{std::int32_t{a}});
+  }
+
+  std::vector<unsigned char> buf(thinks::DeltaEncoder<UnitT>::kHeaderSize +
+                                 thinks::DeltaEncoder<UnitT>::max_encoded_size(count));
+  std::size_t size = 0;
+  const auto enc_s = Seconds([&]() {
+    thinks::DeltaEncoder<UnitT> encoder;
+    size = encoder.write_header(buf.data());
+    size += encoder.encode(angles.data(), count, buf.data() + size);
+  });
+
+  std::vector<UnitT> out(count, 0);
+  thinks::DeltaDecodeResult r = {};
+  const auto dec_s = Seconds([&]() {
+    thinks::DeltaDecoder<UnitT> decoder;
+    if (!decoder.read_header(buf.data(), size)) {
+      std::exit(EXIT_FAILURE);
+    }
+    r = decoder.decode(buf.data() + 8, size - 8, out.data(), count);
+  });
+  if (r.ec != std::errc{} || r.count != count ||
+      !std::equal(angles.begin(), angles.end(), out.begin())) {
+    std::fprintf(stderr, "delta codec failed\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("delta codec: %zu values, %.2f bytes/value, "
+              "encode %.2f G values/s, decode %.2f G values/s\n",
+              count, static_cast<double>(size) / count, count / 1e9 / enc_s,
+              count / 1e9 / dec_s);
+}
+
+// Dose integration over control points, typed versus raw values.
+void BenchIntegration(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<thinks::GrayPerSecond<float>> rates;
+  std::vector<thinks::Milliseconds<float>> dts;
+  rates.reserve(count);
+  dts.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    rates.push_back(thinks::GrayPerSecond<float>{dist(rng)});
+    dts.push_back(thinks::Milliseconds<float>{dist(rng)});
+  }
+  std::vector<thinks::Gray<float>> doses(count, 0.f);
+  const auto typed_s = Seconds([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      doses[i] = thinks::unit_cast<thinks::Gray<float>>(rates[i] * dts[i]);
+    }
+  });
+
+  std::vector<float> raw_rates(count), raw_dts(count), raw_doses(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    raw_rates[i] = rates[i].value();
+    raw_dts[i] = dts[i].value();
+  }
+  const auto raw_s = Seconds([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      raw_doses[i] = raw_rates[i] * raw_dts[i] / 1000;
+    }
+  });
+  if (doses[count / 2].value() != raw_doses[count / 2]) {
+    std::fprintf(stderr, "integration mismatch\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("rate * dt: %zu values, typed %.2f G values/s, raw %.2f G values/s\n",
+              count, count / 1e9 / typed_s, count / 1e9 / raw_s);
+}
+
+// Run f(thread_index) on the given number of threads, returns elapsed
+// seconds.
+template <typename F>
+double ParallelSeconds(const unsigned thread_count, F&& f) {
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  return Seconds([&]() {
+    for (unsigned t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&f, t]() { f(t); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  });
+}
+
+// Concurrent dose deposition into a shared grid, typed atomic units
+// (centigray deposits into a gray grid) versus raw atomic floats.
+// Small grids give high contention.
+void BenchAtomicDeposition(const std::size_t count, const std::size_t voxels) {
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<std::size_t> voxel(0, voxels - 1);
+  std::uniform_real_distribution<float> dose(0.f, 1.f);
+  std::vector<std::size_t> indices(count);
+  std::vector<thinks::CentiGray<float>> deposits;
+  deposits.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    indices[i] = voxel(rng);
+    deposits.push_back(thinks::CentiGray<float>{dose(rng)});
+  }
+
+  for (unsigned thread_count = 1; thread_count <= 64; thread_count *= 2) {
+    const auto chunk = count / thread_count;
+    std::vector<thinks::AtomicUnit<thinks::Gray<float>>> grid(voxels);
+    const auto typed_s = ParallelSeconds(thread_count, [&](const unsigned t) {
+      for (std::size_t i = t * chunk; i < (t + 1) * chunk; ++i) {
+        grid[indices[i]].fetch_add(deposits[i], std::memory_order_relaxed);
+      }
+    });
+
+    std::vector<std::atomic<float>> raw_grid(voxels);
+    for (auto& v : raw_grid) {
+      v.store(0.f);
+    }
+    const auto raw_s = ParallelSeconds(thread_count, [&](const unsigned t) {
+      for (std::size_t i = t * chunk; i < (t + 1) * chunk; ++i) {
+        auto& v = raw_grid[indices[i]];
+        const float d = deposits[i].value() / 100;
+        auto expected = v.load(std::memory_order_relaxed);
+        while (!v.compare_exchange_weak(expected, expected + d,
+                                        std::memory_order_relaxed)) {
+        }
+      }
+    });
+    if (thread_count == 1 && grid[0].load().value() != raw_grid[0].load()) {
+      std::fprintf(stderr, "atomic deposition mismatch\n");
+      std::exit(EXIT_FAILURE);
+    }
+    std::printf("atomic deposition: %zu voxels, %2u threads, "
+                "typed %.1f M/s, raw %.1f M/s\n",
+                voxels, thread_count, thread_count * chunk / 1e6 / typed_s,
+                thread_count * chunk / 1e6 / raw_s);
+  }
+}
+
+// Dose grid statistics, library reductions versus a plain loop over raw
+// values.
+void BenchReductions(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(0.f, 2.f);
+  std::vector<thinks::Gray<float>> doses;
+  doses.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    doses.push_back(thinks::Gray<float>{dist(rng)});
+  }
+  std::vector<float> raw(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    raw[i] = doses[i].value();
+  }
+
+  float raw_sum = 0.f;
+  const auto raw_s = Seconds(
+      [&]() { raw_sum = std::accumulate(raw.begin(), raw.end(), 0.f); });
+  auto seq_sum = thinks::Gray<float>{0.f};
+  const auto seq_s =
+      Seconds([&]() { seq_sum = thinks::sum(doses.data(), count); });
+  auto par_sum = thinks::Gray<float>{0.f};
+  const auto par_s = Seconds([&]() {
+    par_sum = thinks::sum(thinks::execution::par, doses.data(), count);
+  });
+  auto range = std::make_pair(seq_sum, seq_sum);
+  const auto minmax_s = Seconds([&]() {
+    range = thinks::minmax(thinks::execution::par, doses.data(), count);
+  });
+  if (std::abs(seq_sum.value() - raw_sum) > 1e-3f * raw_sum ||
+      std::abs(par_sum.value() - raw_sum) > 1e-3f * raw_sum ||
+      range.second.value() > 2.f) {
+    std::fprintf(stderr, "reduction mismatch\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("sum: %zu values, raw loop %.2f G values/s, seq %.2f G values/s, "
+              "par (%u threads) %.2f G values/s, par minmax %.2f G values/s\n",
+              count, count / 1e9 / raw_s, count / 1e9 / seq_s,
+              std::thread::hardware_concurrency(), count / 1e9 / par_s,
+              count / 1e9 / minmax_s);
+}
+
+// Reproducible versus plain parallel sums for increasing thread counts.
+// The reproducible sums must be bitwise identical.
+void BenchReproducibleSum(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(0.f, 2.f);
+  std::vector<thinks::Gray<float>> doses;
+  doses.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    doses.push_back(thinks::Gray<float>{dist(rng)});
+  }
+
+  const auto expected = thinks::reproducible_sum(doses.data(), count);
+  const auto max_threads = std::max(4U, std::thread::hardware_concurrency());
+  for (unsigned thread_count = 1; thread_count <= max_threads;
+       thread_count *= 2) {
+    auto policy = thinks::execution::par;
+    policy.thread_count = thread_count;
+    auto plain = thinks::Gray<float>{0.f};
+    const auto plain_s =
+        Seconds([&]() { plain = thinks::sum(policy, doses.data(), count); });
+    auto repro = thinks::Gray<float>{0.f};
+    const auto repro_s = Seconds([&]() {
+      repro = thinks::reproducible_sum(policy, doses.data(), count);
+    });
+    if (std::memcmp(&repro, &expected, sizeof(repro)) != 0) {
+      std::fprintf(stderr, "reproducible sum mismatch\n");
+      std::exit(EXIT_FAILURE);
+    }
+    std::printf("reproducible sum: %zu values, %2u threads, "
+                "plain %.2f G values/s (%.9g), reproducible %.2f G values/s (%.9g)\n",
+                count, thread_count, count / 1e9 / plain_s, plain.value(),
+                count / 1e9 / repro_s, repro.value());
+  }
+}
+
+// Mean and standard deviation of a dose stream: two passes over the
+// buffered values versus running statistics with scalar and batch
+// pushes.
+void BenchRunningStats(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::normal_distribution<float> dist(2.f, 0.1f);
+  std::vector<thinks::Gray<float>> doses;
+  doses.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    doses.push_back(thinks::Gray<float>{dist(rng)});
+  }
+
+  double two_pass_stddev = 0.0;
+  const auto two_pass_s = Seconds([&]() {
+    const auto mean = thinks::mean(doses.data(), count).value();
+    double m2 = 0.0;
+    for (const auto d : doses) {
+      m2 += (d.value() - double{mean}) * (d.value() - double{mean});
+    }
+    two_pass_stddev = std::sqrt(m2 / static_cast<double>(count));
+  });
+  thinks::RunningStats<thinks::Gray<float>> scalar;
+  const auto scalar_s = Seconds([&]() {
+    for (const auto d : doses) {
+      scalar.push(d);
+    }
+  });
+  thinks::RunningStats<thinks::Gray<float>> batch;
+  const auto batch_s =
+      Seconds([&]() { batch.push(doses.data(), count); });
+  if (std::abs(batch.stddev().value() - two_pass_stddev) >
+          1e-4 * two_pass_stddev ||
+      std::abs(scalar.stddev().value() - two_pass_stddev) >
+          1e-2 * two_pass_stddev) {
+    std::fprintf(stderr, "running stats mismatch\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("running stats: %zu values, two-pass %.2f G values/s (%.6g), "
+              "scalar push %.2f G values/s (%.6g), batch push %.2f G values/s "
+              "(%.6g)\n",
+              count, count / 1e9 / two_pass_s, two_pass_stddev,
+              count / 1e9 / scalar_s, double{scalar.stddev().value()},
+              count / 1e9 / batch_s, double{batch.stddev().value()});
+}
+
+// Quantiles of gantry angle errors, sketch insert throughput and error
+// versus exact quantiles from a sorted copy.
+void BenchQuantileSketch(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::normal_distribution<double> dist(0.0, 0.1);
+  std::vector<thinks::Degrees<double>> errors;
+  errors.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    errors.push_back(thinks::Degrees<double>{dist(rng)});
+  }
+
+  thinks::QuantileSketch<thinks::Degrees<double>> scalar;
+  const auto scalar_s = Seconds([&]() {
+    for (const auto e : errors) {
+      scalar.push(e);
+    }
+  });
+  thinks::QuantileSketch<thinks::Degrees<double>> batch;
+  const auto batch_s =
+      Seconds([&]() { batch.push(errors.data(), count); });
+  thinks::QuantileSketch<thinks::Degrees<double>> parallel;
+  const auto parallel_s = Seconds([&]() {
+    parallel.push(thinks::execution::par, errors.data(), count);
+  });
+  auto sorted = errors;
+  const auto sort_s =
+      Seconds([&]() { std::sort(sorted.begin(), sorted.end()); });
+  std::printf("quantile sketch: %zu values, scalar push %.1f M values/s, "
+              "batch push %.1f M values/s, parallel push %.1f M values/s, "
+              "sort %.1f M values/s, %zu centroids\n",
+              count, count / 1e6 / scalar_s, count / 1e6 / batch_s,
+              count / 1e6 / parallel_s, count / 1e6 / sort_s,
+              batch.centroid_count());
+
+  for (const auto q : {0.5, 0.95, 0.99, 0.999}) {
+    const auto exact =
+        sorted[static_cast<std::size_t>(q * static_cast<double>(count - 1))];
+    const auto estimate = batch.quantile(q);
+    const auto merged = parallel.quantile(q);
+    // Rank error, the fraction of values between the estimate and the
+    // exact quantile.
+    const auto rank = [&](const thinks::Degrees<double> v) {
+      return static_cast<double>(
+                 std::lower_bound(sorted.begin(), sorted.end(), v) -
+                 sorted.begin()) /
+             static_cast<double>(count);
+    };
+    std::printf("quantile sketch: p%-5g exact %.6f deg, sketch %.6f deg "
+                "(rank error %.2g), merged %.6f deg (rank error %.2g)\n",
+                q * 100, exact.value(), estimate.value(),
+                std::abs(rank(estimate) - q), merged.value(),
+                std::abs(rank(merged) - q));
+  }
+}
+
+// Dose deposition from multiple threads, shared atomic grid versus
+// thread-private tiles (centigray) merged into a gray grid.
+void BenchPrivatizedGrid(const std::size_t count, const std::size_t voxels) {
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<std::size_t> voxel(0, voxels - 1);
+  std::uniform_real_distribution<float> dose(0.f, 1.f);
+  std::vector<std::size_t> indices(count);
+  std::vector<thinks::CentiGray<float>> deposits;
+  deposits.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    indices[i] = voxel(rng);
+    deposits.push_back(thinks::CentiGray<float>{dose(rng)});
+  }
+
+  const auto max_threads = std::max(4U, std::thread::hardware_concurrency());
+  for (unsigned thread_count = 1; thread_count <= max_threads;
+       thread_count *= 2) {
+    const auto chunk = count / thread_count;
+    std::vector<thinks::AtomicUnit<thinks::Gray<float>>> shared(voxels);
+    const auto atomic_s = ParallelSeconds(thread_count, [&](const unsigned t) {
+      for (std::size_t i = t * chunk; i < (t + 1) * chunk; ++i) {
+        shared[indices[i]].fetch_add(deposits[i], std::memory_order_relaxed);
+      }
+    });
+
+    auto grid = thinks::PrivatizedGrid<thinks::CentiGray<float>>(
+        voxels, thread_count);
+    std::vector<thinks::Gray<float>> out(voxels, thinks::Gray<float>{0.f});
+    const auto deposit_s = ParallelSeconds(thread_count, [&](const unsigned t) {
+      for (std::size_t i = t * chunk; i < (t + 1) * chunk; ++i) {
+        grid.add(t, indices[i], deposits[i]);
+      }
+    });
+    auto policy = thinks::execution::par;
+    policy.thread_count = thread_count;
+    const auto merge_s = Seconds([&]() { grid.merge(policy, out.data()); });
+    if (std::abs(out[0].value() - shared[0].load().value()) > 1e-3f) {
+      std::fprintf(stderr, "privatized grid mismatch\n");
+      std::exit(EXIT_FAILURE);
+    }
+    std::printf("privatized grid: %zu voxels, %2u threads, atomic %.1f M/s, "
+                "privatized %.1f M/s (merge %.1f ms)\n",
+                voxels, thread_count, thread_count * chunk / 1e6 / atomic_s,
+                thread_count * chunk / 1e6 / (deposit_s + merge_s),
+                merge_s * 1e3);
+  }
+}
+
+// Producer/consumer latency percentiles, samples are timestamped when
+// pushed and when popped.
+template <typename PushF, typename PopF>
+void BenchQueueLatency(const char* name, const std::size_t count,
+                       PushF&& push, PopF&& pop) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<Clock::time_point> pushed(count);
+  std::vector<double> latencies(count);
+  std::atomic<bool> done{false};
+  std::vector<double> batch(64);
+  const auto s = Seconds([&]() {
+    std::thread producer([&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        pushed[i] = Clock::now();
+        while (!push(static_cast<double>(i))) {
+          std::this_thread::yield();
+        }
+      }
+      done = true;
+    });
+    for (std::size_t received = 0; received < count;) {
+      const auto n = pop(batch.data(), batch.size());
+      const auto now = Clock::now();
+      for (std::size_t i = 0; i < n; ++i) {
+        const auto k = static_cast<std::size_t>(batch[i]);
+        latencies[k] = std::chrono::duration<double>(now - pushed[k]).count();
+      }
+      received += n;
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+  });
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&](const double p) {
+    return latencies[static_cast<std::size_t>(p * (count - 1))] * 1e6;
+  };
+  std::printf("%s: %zu samples, %.1f M samples/s, latency [us] "
+              "p50 %.2f, p99 %.2f, p99.9 %.2f\n",
+              name, count, count / 1e6 / s, percentile(0.5),
+              percentile(0.99), percentile(0.999));
+}
+
+// Telemetry queues, lock-free ring buffers versus a mutex-guarded deque.
+void BenchRingBuffers(const std::size_t count) {
+  using UnitT = thinks::Degrees<double>;
+  constexpr std::size_t kCapacity = 1024;
+  std::vector<UnitT> units(64, UnitT{0.0});
+
+  thinks::SpscRingBuffer<UnitT> spsc(kCapacity);
+  BenchQueueLatency(
+      "spsc ring buffer", count,
+      [&](const double v) { return spsc.try_push(UnitT{double{v}}); },
+      [&](double* out, const std::size_t n) {
+        const auto popped = spsc.pop(units.data(), n);
+        for (std::size_t i = 0; i < popped; ++i) {
+          out[i] = units[i].value();
+        }
+        return popped;
+      });
+
+  thinks::MpscRingBuffer<UnitT> mpsc(kCapacity);
+  BenchQueueLatency(
+      "mpsc ring buffer", count,
+      [&](const double v) { return mpsc.try_push(UnitT{double{v}}); },
+      [&](double* out, const std::size_t n) {
+        const auto popped = mpsc.pop(units.data(), n);
+        for (std::size_t i = 0; i < popped; ++i) {
+          out[i] = units[i].value();
+        }
+        return popped;
+      });
+
+  std::mutex mutex;
+  std::deque<double> deque;
+  BenchQueueLatency(
+      "mutex deque", count,
+      [&](const double v) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deque.size() == kCapacity) {
+          return false;
+        }
+        deque.push_back(v);
+        return true;
+      },
+      [&](double* out, const std::size_t n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto popped = std::min(n, deque.size());
+        std::copy(deque.begin(), deque.begin() + popped, out);
+        deque.erase(deque.begin(), deque.begin() + popped);
+        return popped;
+      });
+}
+
+// Scaling of range algorithms on the work-stealing pool, and the cost of
+// starting many small parallel calls compared to std::async per slice.
+void BenchThreadPool(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(0.f, 2.f);
+  std::vector<thinks::Gray<float>> doses;
+  doses.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    doses.push_back(thinks::Gray<float>{dist(rng)});
+  }
+  std::vector<thinks::CentiGray<float>> converted(count,
+                                                  thinks::CentiGray<float>{0.f});
+
+  const auto max_threads = std::max(4U, std::thread::hardware_concurrency());
+  for (unsigned thread_count = 1; thread_count <= max_threads;
+       thread_count *= 2) {
+    thinks::ThreadPool pool(thread_count - 1);
+    auto policy = thinks::execution::par;
+    policy.executor = pool;
+    auto total = thinks::Gray<float>{0.f};
+    const auto sum_s = Seconds(
+        [&]() { total = thinks::sum(policy, doses.data(), count); });
+    const auto cast_s = Seconds([&]() {
+      thinks::unit_cast(policy, doses.data(), count, converted.data());
+    });
+    if (converted[count / 2].value() != doses[count / 2].value() * 100) {
+      std::fprintf(stderr, "parallel unit_cast mismatch\n");
+      std::exit(EXIT_FAILURE);
+    }
+    std::printf("thread pool: %zu values, %2u threads, sum %.2f G values/s, "
+                "unit_cast %.2f G values/s\n",
+                count, thread_count, count / 1e9 / sum_s,
+                count / 1e9 / cast_s);
+  }
+
+  // Many small calls, e.g. per control point.
+  constexpr std::size_t kCalls = 1000;
+  constexpr std::size_t kSize = std::size_t{1} << 14;
+  thinks::ThreadPool pool(3);
+  auto policy = thinks::execution::par;
+  policy.grain_size = kSize / 4;
+  policy.executor = pool;
+  const auto pool_s = Seconds([&]() {
+    for (std::size_t c = 0; c < kCalls; ++c) {
+      thinks::unit_cast(policy, doses.data(), kSize, converted.data());
+    }
+  });
+  const auto async_s = Seconds([&]() {
+    for (std::size_t c = 0; c < kCalls; ++c) {
+      std::vector<std::future<void>> slices;
+      for (std::size_t k = 0; k < 4; ++k) {
+        slices.push_back(std::async(std::launch::async, [&, k]() {
+          const auto first = k * kSize / 4;
+          thinks::unit_cast(doses.data() + first, kSize / 4,
+                            converted.data() + first);
+        }));
+      }
+      for (auto& slice : slices) {
+        slice.get();
+      }
+    }
+  });
+  std::printf("thread pool: %zu calls of %zu values, pool %.1f us/call, "
+              "std::async %.1f us/call\n",
+              kCalls, kSize, pool_s * 1e6 / kCalls, async_s * 1e6 / kCalls);
+}
+
+// Sines and cosines of angles, e.g. gantry angles, with std::sin and
+// std::cos of the angles converted to radians versus the batch kernels.
+template <typename AngleT>
+void BenchTrig(const char* name, const std::size_t count) {
+  using ValueT = typename AngleT::ValueType;
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<ValueT> dist(ValueT{-360}, ValueT{360});
+  std::vector<AngleT> angles;
+  angles.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    angles.push_back(AngleT{dist(rng)});
+  }
+
+  std::vector<ValueT> std_sin(count);
+  std::vector<ValueT> std_cos(count);
+  const auto std_s = Seconds([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto radians =
+          thinks::unit_cast<thinks::Radians<ValueT>>(angles[i]).value();
+      std_sin[i] = std::sin(radians);
+      std_cos[i] = std::cos(radians);
+    }
+  });
+  std::vector<ValueT> sin_out(count);
+  std::vector<ValueT> cos_out(count);
+  const auto sin_s =
+      Seconds([&]() { thinks::sin(angles.data(), count, sin_out.data()); });
+  const auto sincos_s = Seconds([&]() {
+    thinks::sincos(angles.data(), count, sin_out.data(), cos_out.data());
+  });
+  for (std::size_t i = 0; i < count; ++i) {
+    // The std reference is off by the rounding of the radians.
+    if (std::abs(sin_out[i] - std_sin[i]) > ValueT{1e-5} ||
+        std::abs(cos_out[i] - std_cos[i]) > ValueT{1e-5}) {
+      std::fprintf(stderr, "trig mismatch\n");
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  std::printf("trig %s: %zu angles, std::sin + std::cos %.2f G angles/s, "
+              "sin %.2f G angles/s, sincos %.2f G angles/s\n",
+              name, count, count / 1e9 / std_s, count / 1e9 / sin_s,
+              count / 1e9 / sincos_s);
+}
+
+#if THINKS_UNITS_HAS_COROUTINES
+void BenchStreamCast(const std::size_t count) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(0.f, 200.f);
+  std::vector<float> file(count);
+  for (auto& v : file) {
+    v = dist(rng);
+  }
+
+  // Reader of centigray values from an in-memory "file", with a fixed
+  // latency per read as a stand-in for disk or network I/O.
+  constexpr std::size_t kChunkSize = std::size_t{1} << 16;
+  constexpr auto kLatency = std::chrono::microseconds(200);
+  const auto make_source = [&file, count, kLatency]() {
+    return [&file, count, kLatency, offset = std::size_t{0}](
+               thinks::CentiGray<float>* data,
+               const std::size_t max_count) mutable {
+      std::this_thread::sleep_for(kLatency);
+      const auto n = std::min(max_count, count - offset);
+      for (std::size_t i = 0; i < n; ++i) {
+        data[i] = thinks::CentiGray<float>{float{file[offset + i]}};
+      }
+      offset += n;
+      return n;
+    };
+  };
+
+  // Read a chunk, then convert it.
+  auto serial_total = thinks::Gray<double>{0.0};
+  const auto serial_s = Seconds([&]() {
+    auto source = make_source();
+    std::vector<thinks::CentiGray<float>> raw(kChunkSize,
+                                              thinks::CentiGray<float>{0.f});
+    std::vector<thinks::Gray<float>> converted(kChunkSize,
+                                               thinks::Gray<float>{0.f});
+    for (;;) {
+      const auto n = source(raw.data(), kChunkSize);
+      if (n == 0) {
+        break;
+      }
+      thinks::unit_cast(raw.data(), n, converted.data());
+      serial_total += thinks::sum(converted.data(), n);
+    }
+  });
+
+  auto stream_total = thinks::Gray<double>{0.0};
+  const auto stream_s = Seconds([&]() {
+    for (const auto chunk :
+         thinks::stream_cast<thinks::Gray<float>, thinks::CentiGray<float>>(
+             make_source(), kChunkSize)) {
+      stream_total += thinks::sum(chunk.data(), chunk.size());
+    }
+  });
+  if (std::abs(stream_total.value() - serial_total.value()) >
+      1e-6 * std::abs(serial_total.value())) {
+    std::fprintf(stderr, "stream_cast mismatch\n");
+    std::exit(EXIT_FAILURE);
+  }
+  std::printf("stream_cast: %zu values, read then convert %.2f M values/s, "
+              "stream_cast %.2f M values/s\n",
+              count, count / 1e6 / serial_s, count / 1e6 / stream_s);
+}
+#endif
+
+}  // namespace
+
+// Usage: thinks_units_bench [megabytes]
+int main(int argc, char* argv[]) {
+  const std::size_t mb =
+      argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10))
+               : 64;
+  BenchParseLines(mb << 20);
+  BenchDeltaCodec((mb << 20) / sizeof(std::int32_t));
+  BenchIntegration((mb << 20) / sizeof(float));
+  BenchPrivatizedGrid((mb << 20) / sizeof(float), std::size_t{1} << 21);
+  BenchReductions((mb << 20) / sizeof(float));
+  BenchRingBuffers((mb << 20) / 64);
+  BenchReproducibleSum((mb << 20) / sizeof(float));
+  BenchRunningStats((mb << 20) / sizeof(float));
+  BenchQuantileSketch((mb << 20) / sizeof(double));
+  BenchThreadPool((mb << 20) / sizeof(float));
+  BenchTrig<thinks::Degrees<float>>("degrees<float>",
+                                    (mb << 20) / sizeof(float));
+  BenchTrig<thinks::Degrees<double>>("degrees<double>",
+                                     (mb << 20) / sizeof(double));
+  BenchTrig<thinks::Radians<float>>("radians<float>",
+                                    (mb << 20) / sizeof(float));
+#if THINKS_UNITS_HAS_COROUTINES
+  BenchStreamCast((mb << 20) / sizeof(float));
+#endif
+  BenchAtomicDeposition((mb << 20) / sizeof(float), std::size_t{1} << 18);
+  BenchAtomicDeposition((mb << 20) / sizeof(float), 64);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Compile-time stress test. Instantiates the unit operators for a large
+// number of distinct scales, such that the frontend cost of the header
+// dominates. Used to compare language modes (e.g. C++17 vs. C++20 with
+// concepts) using the compiler's own timers, for example:
+//
+//   g++ -std=c++20 -fsyntax-only -ftime-report units_compile_stress.cc
+//   clang++ -std=c++20 -fsyntax-only -ftime-trace units_compile_stress.cc
+
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <utility>
+
+#include "thinks/units/units_algorithms.h"
+#include "thinks/units/units_core.h"
+
+#ifndef THINKS_UNITS_STRESS_COUNT
+#define THINKS_UNITS_STRESS_COUNT 256
+#endif
+
+namespace {
+
+using LengthTag = thinks::Meters<double>::TagType;
+
+template <std::intmax_t N>
+using StressLength = thinks::Unit<double, std::ratio<1, N>, LengthTag>;
+template <std::intmax_t N>
+using StressIntLength = thinks::Unit<int, std::ratio<1, N>, LengthTag>;
+
+template <std::intmax_t N>
+constexpr auto Exercise() -> double {
+  auto a = StressLength<N>{1.0};
+  const auto b = StressLength<N + 1>{2.0};
+  const auto c = StressIntLength<N>{3};
+  a += b;
+  a -= c;
+  a *= 2;
+  a /= 2;
+  const auto area = a * b;
+  const auto sum = (a + a) * 2.0 + 2.0 * a - a / 2.0;
+  const auto cmp = (a == b) + (a != c) + (a < b) + (a >= c);
+  return sum.value() + area.value() + a / b + cmp +
+         thinks::unit_cast<StressLength<N + 2>>(c).value() +
+         thinks::max(a, b).value() + thinks::clamp(c, a, b).value();
+}
+
+template <std::size_t... Is>
+constexpr auto ExerciseAll(std::index_sequence<Is...>) -> double {
+  return (Exercise<static_cast<std::intmax_t>(Is) + 1>() + ...);
+}
+
+}  // namespace
+
+int main() {
+  constexpr auto kResult = ExerciseAll(
+      std::make_index_sequence<THINKS_UNITS_STRESS_COUNT>{});
+  return kResult != 0.0 ? 0 : 1;
+}
@@ -0,0 +1,1423 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Unit class template, operators, conversions and the built-in tags, 
+// scales and aliases.
+
+#pragma once
+
+#include <chrono>
+#if defined(__cpp_impl_three_way_comparison)
+#include <compare>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ratio>
+#include <type_traits>
+#include <utility>
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+// With concepts, template constraints are checked during overload 
+// resolution as requires-clauses, without instantiating function bodies. 
+// Otherwise SFINAE and static_asserts are used.
+#if defined(__cpp_concepts) && (__cpp_concepts >= 201907L)
+  #define THINKS_UNITS_HAS_CONCEPTS 1
+#else
+  #define THINKS_UNITS_HAS_CONCEPTS 0
+#endif
+
+namespace thinks {
+namespace units_internal {
+
+// Base dimensions.
+struct LengthBase;
+struct AngleBase;
+struct DoseBase;
+struct TimeBase;
+
+// Name strings for base dimensions. Used to order base dimensions within
+// a dimension and when identifying units outside of the type system
+// (e.g. serialization fingerprints), so names must be unique.
+template <typename BaseT>
+struct BaseName;  // Generic, not implemented.
+template <>
+struct BaseName<LengthBase> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "length"; }
+};
+template <>
+struct BaseName<AngleBase> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "angle"; }
+};
+template <>
+struct BaseName<DoseBase> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "dose"; }
+};
+template <>
+struct BaseName<TimeBase> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "time"; }
+};
+
+// A base dimension raised to an integer power.
+template <typename BaseT, int Exp>
+struct Power {
+  using BaseType = BaseT;
+  static constexpr int exponent = Exp;
+};
+
+// Compile-time exponent vector, e.g. Dimension<Power<LengthBase, 2>> for
+// area. Powers are sorted by base name and never have zero exponents, 
+// such that each dimension has exactly one type. Use DimensionMultiply 
+// and DimensionDivide rather than spelling out derived dimensions.
+template <typename... Powers>
+struct Dimension {};
+
+using Dimensionless = Dimension<>;
+
+NO_DISCARD constexpr auto CompareNames(const char* a, const char* b) noexcept
+    -> int {
+  for (; *a != '\0' && *a == *b; ++a, ++b) {}
+  return *a == *b ? 0 : (static_cast<unsigned char>(*a) < 
+                         static_cast<unsigned char>(*b) ? -1 : 1);
+}
+
+template <typename PowerT, typename DimT>
+struct DimensionPrepend;
+template <typename PowerT, typename... Ps>
+struct DimensionPrepend<PowerT, Dimension<Ps...>> {
+  using type = Dimension<PowerT, Ps...>;
+};
+
+// Merge two sorted exponent vectors, adding exponents of shared bases.
+template <typename Dim1T, typename Dim2T>
+struct DimensionMerge;
+
+template <int Order, typename Dim1T, typename Dim2T>
+struct DimensionMergeImpl;
+template <typename P, typename... Ps, typename Q, typename... Qs>
+struct DimensionMergeImpl<-1, Dimension<P, Ps...>, Dimension<Q, Qs...>> {
+  using type = typename DimensionPrepend<
+      P, typename DimensionMerge<Dimension<Ps...>, 
+                                 Dimension<Q, Qs...>>::type>::type;
+};
+template <typename P, typename... Ps, typename Q, typename... Qs>
+struct DimensionMergeImpl<1, Dimension<P, Ps...>, Dimension<Q, Qs...>> {
+  using type = typename DimensionPrepend<
+      Q, typename DimensionMerge<Dimension<P, Ps...>, 
+                                 Dimension<Qs...>>::type>::type;
+};
+template <typename P, typename... Ps, typename Q, typename... Qs>
+struct DimensionMergeImpl<0, Dimension<P, Ps...>, Dimension<Q, Qs...>> {
+  using TailT = 
+      typename DimensionMerge<Dimension<Ps...>, Dimension<Qs...>>::type;
+  static constexpr int kExp = P::exponent + Q::exponent;
+  using type = std::conditional_t<
+      kExp == 0, TailT,
+      typename DimensionPrepend<Power<typename P::BaseType, kExp>, 
+                                TailT>::type>;
+};
+
+template <>
+struct DimensionMerge<Dimension<>, Dimension<>> {
+  using type = Dimension<>;
+};
+template <typename P, typename... Ps>
+struct DimensionMerge<Dimension<P, Ps...>, Dimension<>> {
+  using type = Dimension<P, Ps...>;
+};
+template <typename Q, typename... Qs>
+struct DimensionMerge<Dimension<>, Dimension<Q, Qs...>> {
+  using type = Dimension<Q, Qs...>;
+};
+template <typename P, typename... Ps, typename Q, typename... Qs>
+struct DimensionMerge<Dimension<P, Ps...>, Dimension<Q, Qs...>> {
+  using type = typename DimensionMergeImpl<
+      CompareNames(BaseName<typename P::BaseType>::c_str(),
+                   BaseName<typename Q::BaseType>::c_str()),
+      Dimension<P, Ps...>, Dimension<Q, Qs...>>::type;
+};
+
+template <typename DimT>
+struct DimensionInverse;
+template <typename... Ps>
+struct DimensionInverse<Dimension<Ps...>> {
+  using type = Dimension<Power<typename Ps::BaseType, -Ps::exponent>...>;
+};
+
+template <typename Dim1T, typename Dim2T>
+using DimensionMultiply = typename DimensionMerge<Dim1T, Dim2T>::type;
+template <typename Dim1T, typename Dim2T>
+using DimensionDivide = 
+    typename DimensionMerge<Dim1T, typename DimensionInverse<Dim2T>::type>::type;
+
+// Categories.
+using LengthTag = Dimension<Power<LengthBase, 1>>;
+using AngleTag = Dimension<Power<AngleBase, 1>>;
+using DoseTag = Dimension<Power<DoseBase, 1>>;
+using TimeTag = Dimension<Power<TimeBase, 1>>;
+using AreaTag = DimensionMultiply<LengthTag, LengthTag>;
+using VolumeTag = DimensionMultiply<AreaTag, LengthTag>;
+using DoseRateTag = DimensionDivide<DoseTag, TimeTag>;
+using AngularVelocityTag = DimensionDivide<AngleTag, TimeTag>;
+
+// Scale factor that includes an integer power of pi, i.e. RatioT * pi^PiExp.
+// Scales without pi are plain std::ratio types, use MakeScale to get 
+// the canonical representation.
+template <typename RatioT, int PiExp>
+struct PiScale {
+  using RatioType = RatioT;
+  static constexpr int pi_exponent = PiExp;
+};
+
+template <typename RatioT, int PiExp>
+using MakeScale = 
+    std::conditional_t<PiExp == 0, RatioT, PiScale<RatioT, PiExp>>;
+
+// Decompose a scale into its rational part and pi exponent.
+template <typename ScaleT>
+struct ScaleTraits {
+  using RatioType = ScaleT;
+  static constexpr int pi_exponent = 0;
+};
+template <typename RatioT, int PiExp>
+struct ScaleTraits<PiScale<RatioT, PiExp>> {
+  using RatioType = RatioT;
+  static constexpr int pi_exponent = PiExp;
+};
+
+// Overflow-resistant rational arithmetic for scale factors. Common 
+// factors are cancelled before multiplying, such that the computation
+// only overflows if the reduced result itself cannot be represented.
+// Unlike std::ratio_multiply, overflow is reported rather than being 
+// a compilation error.
+struct Rational {
+  std::intmax_t num;
+  std::intmax_t den;
+  bool overflow;
+};
+
+NO_DISCARD constexpr auto Gcd(std::intmax_t a, std::intmax_t b) noexcept 
+    -> std::intmax_t {
+  a = a < 0 ? -a : a;
+  b = b < 0 ? -b : b;
+  while (b != 0) {
+    const auto t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+NO_DISCARD constexpr auto MultiplyOverflows(const std::intmax_t a,
+                                            const std::intmax_t b) noexcept 
+    -> bool {
+  constexpr auto kMax = std::numeric_limits<std::intmax_t>::max();
+  const auto ua = a < 0 ? -static_cast<std::uintmax_t>(a) 
+                        : static_cast<std::uintmax_t>(a);
+  const auto ub = b < 0 ? -static_cast<std::uintmax_t>(b) 
+                        : static_cast<std::uintmax_t>(b);
+  return ua != 0 && ub > static_cast<std::uintmax_t>(kMax) / ua;
+}
+
+// (n1 / d1) * (n2 / d2), denominators must be non-zero.
+NO_DISCARD constexpr auto RationalMultiply(
+    const std::intmax_t n1, const std::intmax_t d1, 
+    const std::intmax_t n2, const std::intmax_t d2) noexcept -> Rational {
+  const auto g1 = Gcd(n1, d2);
+  const auto g2 = Gcd(n2, d1);
+  const auto a = n1 / g1;
+  const auto b = d2 / g1;
+  const auto c = n2 / g2;
+  const auto d = d1 / g2;
+  if (MultiplyOverflows(a, c) || MultiplyOverflows(d, b)) {
+    return {0, 1, true};
+  }
+  // Keep the sign in the numerator.
+  const auto den = d * b;
+  return den < 0 ? Rational{-(a * c), -den, false} 
+                 : Rational{a * c, den, false};
+}
+
+// Product and quotient of scales. Scale factors of units are typically 
+// small, if the result is not representable as a ratio compilation fails 
+// with a message saying so.
+template <typename Scale1T, typename Scale2T, bool Divide>
+struct ScaleCombine {
+  using Ratio1T = typename ScaleTraits<Scale1T>::RatioType;
+  using Ratio2T = typename ScaleTraits<Scale2T>::RatioType;
+  static constexpr Rational kRatio = 
+      Divide ? RationalMultiply(Ratio1T::num, Ratio1T::den, 
+                                Ratio2T::den, Ratio2T::num)
+             : RationalMultiply(Ratio1T::num, Ratio1T::den, 
+                                Ratio2T::num, Ratio2T::den);
+  static_assert(!kRatio.overflow, "scale is not representable as a ratio");
+  using type = MakeScale<
+      std::ratio<kRatio.num, kRatio.den>,
+      ScaleTraits<Scale1T>::pi_exponent + 
+          (Divide ? -1 : 1) * ScaleTraits<Scale2T>::pi_exponent>;
+};
+
+template <typename Scale1T, typename Scale2T>
+using ScaleMultiply = typename ScaleCombine<Scale1T, Scale2T, false>::type;
+template <typename Scale1T, typename Scale2T>
+using ScaleDivide = typename ScaleCombine<Scale1T, Scale2T, true>::type;
+
+// Define scale factors for lengths. 
+// Using centimeters as unit length.
+using MeterScale = std::ratio<100, 1>::type;
+using CentimeterScale = std::ratio<1>::type; // Unit length.
+using MillimeterScale = std::ratio<1, 10>::type;
+
+// Define scale factors for areas and volumes, derived from lengths.
+using SquareMeterScale = std::ratio_multiply<MeterScale, MeterScale>::type;
+using SquareCentimeterScale = 
+    std::ratio_multiply<CentimeterScale, CentimeterScale>::type;
+using SquareMillimeterScale = 
+    std::ratio_multiply<MillimeterScale, MillimeterScale>::type;
+using CubicCentimeterScale = 
+    std::ratio_multiply<SquareCentimeterScale, CentimeterScale>::type;
+using CubicMillimeterScale = 
+    std::ratio_multiply<SquareMillimeterScale, MillimeterScale>::type;
+
+// Define scale factors for angles.
+// Using degrees as unit angle.
+using DegreeScale = std::ratio<1>::type; // Unit angle.
+using RadianScale = PiScale<std::ratio<180>, -1>; // Exactly 180/pi.
+
+// Define scale factors for Gray, defined as the absorption of 
+// one joule of radiation energy per kilogram of matter.
+using GrayScale = std::ratio<1>::type; // Unit absorption.
+using CentiGrayScale = std::ratio<1, 100>::type;
+
+// Define scale factors for time.
+// Using seconds as unit time, such that time scales can be used directly 
+// as std::chrono::duration periods.
+using SecondScale = std::ratio<1>::type; // Unit time.
+using MillisecondScale = std::ratio<1, 1000>::type;
+
+// Define scale factors for rates, derived from the above.
+using GrayPerSecondScale = ScaleDivide<GrayScale, SecondScale>;
+using DegreePerSecondScale = ScaleDivide<DegreeScale, SecondScale>;
+
+// std::ratio traits.
+template <typename T>
+struct is_ratio : public std::false_type {};
+template <std::intmax_t Num, std::intmax_t Denom>
+struct is_ratio<std::ratio<Num, Denom>> : public std::true_type {};
+template <typename T>
+constexpr bool is_ratio_v = is_ratio<T>::value;
+
+// Scale traits, a scale is a ratio optionally multiplied by a power of pi.
+template <typename T>
+struct is_scale : public is_ratio<T> {};
+template <typename RatioT, int PiExp>
+struct is_scale<PiScale<RatioT, PiExp>> : public is_ratio<RatioT> {};
+template <typename T>
+constexpr bool is_scale_v = is_scale<T>::value;
+
+// Tag (category) traits. Any dimension is a valid tag.
+template <typename T>
+struct is_tag : public std::false_type {};
+template <typename... Ps>
+struct is_tag<Dimension<Ps...>> : public std::true_type {};
+template <typename T>
+constexpr bool is_tag_v = is_tag<T>::value;
+
+#if THINKS_UNITS_HAS_CONCEPTS
+template <typename T>
+concept arithmetic = std::is_arithmetic_v<T>;
+template <typename T>
+concept scale = is_scale_v<T>;
+template <typename T>
+concept tag = is_tag_v<T>;
+#endif
+
+// TODO(thinks): Implement range checking, similar to boost::numeric_cast.
+template <typename ToArithT, typename FromArithT>
+NO_DISCARD constexpr auto numeric_cast(
+    const FromArithT v) /*noexcept*/ -> ToArithT {
+  return static_cast<ToArithT>(v);
+}
+
+// Double-double arithmetic, i.e. unevaluated sums hi + lo of doubles 
+// giving about 106 bits of precision. Used to compute scale factors 
+// involving pi at compile-time, such that they are correctly rounded 
+// when stored as double (or narrower) constants.
+struct DoubleDouble {
+  double hi;
+  double lo;
+};
+
+NO_DISCARD constexpr auto QuickTwoSum(const double a, const double b) noexcept
+    -> DoubleDouble {
+  const double s = a + b;
+  return {s, b - (s - a)};
+}
+
+NO_DISCARD constexpr auto TwoSum(const double a, const double b) noexcept 
+    -> DoubleDouble {
+  const double s = a + b;
+  const double bb = s - a;
+  return {s, (a - (s - bb)) + (b - bb)};
+}
+
+// Dekker's product, exact without relying on fused multiply-add.
+NO_DISCARD constexpr auto TwoProd(const double a, const double b) noexcept 
+    -> DoubleDouble {
+  constexpr double kSplit = 134217729.0;  // 2^27 + 1.
+  const double p = a * b;
+  const double ca = kSplit * a;
+  const double ahi = ca - (ca - a);
+  const double alo = a - ahi;
+  const double cb = kSplit * b;
+  const double bhi = cb - (cb - b);
+  const double blo = b - bhi;
+  return {p, ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo};
+}
+
+NO_DISCARD constexpr auto Add(const DoubleDouble a, 
+                              const DoubleDouble b) noexcept -> DoubleDouble {
+  const auto s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, s.lo + a.lo + b.lo);
+}
+
+NO_DISCARD constexpr auto Mul(const DoubleDouble a, 
+                              const DoubleDouble b) noexcept -> DoubleDouble {
+  const auto p = TwoProd(a.hi, b.hi);
+  return QuickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+NO_DISCARD constexpr auto Div(const DoubleDouble a, 
+                              const DoubleDouble b) noexcept -> DoubleDouble {
+  // Long division, three partial quotients.
+  const double q1 = a.hi / b.hi;
+  auto r = Add(a, Mul({-q1, 0.0}, b));
+  const double q2 = r.hi / b.hi;
+  r = Add(r, Mul({-q2, 0.0}, b));
+  const double q3 = r.hi / b.hi;
+  return Add(QuickTwoSum(q1, q2), {q3, 0.0});
+}
+
+NO_DISCARD constexpr auto ToDoubleDouble(const std::intmax_t v) noexcept 
+    -> DoubleDouble {
+  // Split into two halves that are exactly representable as doubles.
+  constexpr std::intmax_t kHalf = std::intmax_t{1} << 32;
+  const std::intmax_t hi = (v / kHalf) * kHalf;
+  return QuickTwoSum(static_cast<double>(hi), static_cast<double>(v - hi));
+}
+
+inline constexpr DoubleDouble kPi = {3.141592653589793116e+00, 
+                                     1.224646799147353207e-16};
+
+// (FromRatioT / ToRatioT) * pi^PiExp in double-double precision. Never 
+// overflows, regardless of the magnitude of the ratios.
+template <typename FromRatioT, typename ToRatioT, int PiExp>
+NO_DISCARD constexpr auto ScaleFactor() noexcept -> DoubleDouble {
+  auto f = Mul(Div(ToDoubleDouble(FromRatioT::num), 
+                   ToDoubleDouble(FromRatioT::den)),
+               Div(ToDoubleDouble(ToRatioT::den), 
+                   ToDoubleDouble(ToRatioT::num)));
+  for (int i = 0; i < PiExp; ++i) {
+    f = Mul(f, kPi);
+  }
+  for (int i = 0; i > PiExp; --i) {
+    f = Div(f, kPi);
+  }
+  return f;
+}
+
+template <typename FloatT>
+NO_DISCARD constexpr auto RoundTo(const DoubleDouble v) noexcept -> FloatT {
+  if constexpr (std::is_same_v<FloatT, long double>) {
+    return static_cast<long double>(v.hi) + static_cast<long double>(v.lo);
+  } else {
+    // The high part is already correctly rounded to double. For narrower
+    // types the low part decides when the high part is exactly halfway 
+    // between two representable values.
+    const auto f = static_cast<FloatT>(v.hi);
+    const double d = v.hi - static_cast<double>(f);
+    const double g = static_cast<double>(f) + 2 * d;
+    const bool halfway = 
+        d != 0 && static_cast<double>(static_cast<FloatT>(g)) == g;
+    return halfway && v.lo != 0 && ((d > 0) == (v.lo > 0)) 
+               ? static_cast<FloatT>(g) : f;
+  }
+}
+
+// Utility for applying scale factors and converting between 
+// different value types.
+template <typename FromScaleT, typename ToScaleT>
+#if THINKS_UNITS_HAS_CONCEPTS
+  requires scale<FromScaleT> && scale<ToScaleT>
+#endif
+struct ScaleHelper {
+#if !THINKS_UNITS_HAS_CONCEPTS
+  static_assert(is_scale_v<FromScaleT>, "FromScaleT must be a scale");
+  static_assert(is_scale_v<ToScaleT>, "ToScaleT must be a scale");
+#endif
+  using FromRatioT = typename ScaleTraits<FromScaleT>::RatioType;
+  using ToRatioT = typename ScaleTraits<ToScaleT>::RatioType;
+  static constexpr Rational kRatio = RationalMultiply(
+      FromRatioT::num, FromRatioT::den, ToRatioT::den, ToRatioT::num);
+  static constexpr int kPiExponent = 
+      ScaleTraits<FromScaleT>::pi_exponent - ScaleTraits<ToScaleT>::pi_exponent;
+
+  // clang-format off
+  template <typename ToArithT, typename FromArithT>
+#if THINKS_UNITS_HAS_CONCEPTS
+    requires arithmetic<ToArithT> && arithmetic<FromArithT>
+#endif
+  NO_DISCARD constexpr static auto Scale(const FromArithT v) 
+      //noexcept(noexcept(static_cast<ToArithT>((kRatio.num * v) / kRatio.den))) 
+      -> ToArithT {
+#if !THINKS_UNITS_HAS_CONCEPTS
+    static_assert(std::is_arithmetic_v<FromArithT>, 
+                  "FromArithT must be arithmetic");
+    static_assert(std::is_arithmetic_v<ToArithT>,
+                  "ToArithT must be arithmetic");
+#endif
+
+    // Arithmetic is done in the common type, such that e.g. integer 
+    // values are not truncated before being converted to floating point.
+    using CommonT = std::common_type_t<FromArithT, ToArithT>;
+    if constexpr (kPiExponent != 0 || kRatio.overflow) {
+      // Irrational factor, or a ratio that cannot be represented exactly:
+      // a single multiplication by a correctly rounded constant. Integers
+      // are scaled in double precision.
+      using FloatT = 
+          std::conditional_t<std::is_floating_point_v<CommonT>, CommonT, double>;
+      constexpr auto kFactor = RoundTo<FloatT>(
+          ScaleFactor<FromRatioT, ToRatioT, kPiExponent>());
+      return numeric_cast<ToArithT>(static_cast<FloatT>(v) * kFactor);
+    } else if constexpr (kRatio.num == 1 && kRatio.den == 1) {
+      return numeric_cast<ToArithT>(v);
+    } else {
+      // Denominator is guaranteed to be non-zero.
+      return numeric_cast<ToArithT>(
+          (kRatio.num * static_cast<CommonT>(v)) / kRatio.den);
+    }
+  }
+  // clang-format on
+};
+
+// Number of bits needed to multiply by a positive integer without
+// wrapping, i.e. ceil(log2(v)).
+NO_DISCARD constexpr auto MultiplierBits(const std::intmax_t v) noexcept
+    -> int {
+  int bits = 0;
+  for (auto x = v - 1; x > 0; x >>= 1) {
+    ++bits;
+  }
+  return bits;
+}
+
+// Signed integer type with at least Digits value bits, void when no such
+// type is available.
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 Int128;
+#endif
+template <int Digits>
+struct WideIntegerImpl {
+#if defined(__SIZEOF_INT128__)
+  using type = std::conditional_t<
+      (Digits <= std::numeric_limits<std::intmax_t>::digits), std::intmax_t,
+      std::conditional_t<(Digits <= 127), Int128, void>>;
+#else
+  using type = std::conditional_t<
+      (Digits <= std::numeric_limits<std::intmax_t>::digits), std::intmax_t,
+      void>;
+#endif
+};
+
+// Maps the values of two same-tag units, with scales Scale1T and Scale2T,
+// to a common scale where they can be compared directly.
+//
+// For rational scale ratios N/D integers are compared as a * N < b * D,
+// without division, in an integer type wide enough for both products,
+// such that the result is exact. Multiplications by one are removed at
+// compile time, so that e.g. millimeters and centimeters compare with a
+// single multiplication. Floating point values, irrational (or
+// overflowing) ratios and integer products too wide for any available
+// type fold into one multiplication by a correctly rounded constant,
+// preferring integer constants (e.g. a * 10 < b rather than
+// a < b * 0.1).
+template <typename Scale1T, typename Scale2T, typename Arith1T,
+          typename Arith2T>
+struct CompareHelper {
+  using Helper = ScaleHelper<Scale1T, Scale2T>;
+  static constexpr bool kRational =
+      Helper::kPiExponent == 0 && !Helper::kRatio.overflow;
+  static constexpr bool kIntegral =
+      std::is_integral_v<Arith1T> && std::is_integral_v<Arith2T>;
+
+  // Value bits of the products a * N and b * D.
+  static constexpr int kLhsDigits = std::numeric_limits<Arith1T>::digits +
+                                    MultiplierBits(Helper::kRatio.num);
+  static constexpr int kRhsDigits = std::numeric_limits<Arith2T>::digits +
+                                    MultiplierBits(Helper::kRatio.den);
+  static constexpr int kWideDigits =
+      kLhsDigits > kRhsDigits ? kLhsDigits : kRhsDigits;
+  using WideT = typename WideIntegerImpl<kWideDigits>::type;
+  static constexpr bool kExact =
+      kRational && kIntegral && !std::is_void_v<WideT>;
+
+  using FloatT = std::conditional_t<
+      std::is_floating_point_v<std::common_type_t<Arith1T, Arith2T>>,
+      std::common_type_t<Arith1T, Arith2T>, double>;
+  using CommonT = std::conditional_t<kExact, WideT, FloatT>;
+
+  // Single factor for the inexact comparison, applied to the left-hand
+  // side when N is an integer, otherwise to the right-hand side.
+  static constexpr bool kScaleLhs =
+      !kExact && kRational && Helper::kRatio.den == 1;
+  static constexpr CommonT kFactor = kExact ? CommonT{1}
+      : kScaleLhs
+          ? RoundTo<FloatT>(ScaleFactor<typename Helper::FromRatioT,
+                                        typename Helper::ToRatioT, 0>())
+          : RoundTo<FloatT>(ScaleFactor<typename Helper::ToRatioT,
+                                        typename Helper::FromRatioT,
+                                        -Helper::kPiExponent>());
+
+  NO_DISCARD static constexpr auto Lhs(const Arith1T v) noexcept -> CommonT {
+    if constexpr (kExact && Helper::kRatio.num != 1) {
+      return static_cast<CommonT>(v) *
+             static_cast<CommonT>(Helper::kRatio.num);
+    } else if constexpr (kScaleLhs && Helper::kRatio.num != 1) {
+      return static_cast<CommonT>(v) * kFactor;
+    } else {
+      return static_cast<CommonT>(v);
+    }
+  }
+
+  NO_DISCARD static constexpr auto Rhs(const Arith2T v) noexcept -> CommonT {
+    if constexpr (kExact && Helper::kRatio.den != 1) {
+      return static_cast<CommonT>(v) *
+             static_cast<CommonT>(Helper::kRatio.den);
+    } else if constexpr (!kExact && !kScaleLhs) {
+      return static_cast<CommonT>(v) * kFactor;
+    } else {
+      return static_cast<CommonT>(v);
+    }
+  }
+};
+
+// Suffix string based on scale and category tag.
+template <typename ScaleT, typename TagT>
+struct TagSuffix;  // Generic, not implementd.
+template <>
+struct TagSuffix<units_internal::MeterScale, units_internal::LengthTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "m"; }
+};
+template <>
+struct TagSuffix<units_internal::CentimeterScale, units_internal::LengthTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "cm"; }
+};
+template <>
+struct TagSuffix<units_internal::MillimeterScale, units_internal::LengthTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "mm"; }
+};
+template <>
+struct TagSuffix<units_internal::SquareMeterScale, units_internal::AreaTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "m^2"; }
+};
+template <>
+struct TagSuffix<units_internal::SquareCentimeterScale, 
+                 units_internal::AreaTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "cm^2"; }
+};
+template <>
+struct TagSuffix<units_internal::SquareMillimeterScale, 
+                 units_internal::AreaTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "mm^2"; }
+};
+template <>
+struct TagSuffix<units_internal::CubicCentimeterScale, 
+                 units_internal::VolumeTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "cm^3"; }
+};
+template <>
+struct TagSuffix<units_internal::CubicMillimeterScale, 
+                 units_internal::VolumeTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "mm^3"; }
+};
+template <>
+struct TagSuffix<units_internal::DegreeScale, units_internal::AngleTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "deg"; }
+};
+template <>
+struct TagSuffix<units_internal::RadianScale, units_internal::AngleTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "rad"; }
+};
+template <>
+struct TagSuffix<units_internal::GrayScale, units_internal::DoseTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "Gy"; }
+};
+template <>
+struct TagSuffix<units_internal::CentiGrayScale, units_internal::DoseTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "cGy"; }
+};
+template <>
+struct TagSuffix<units_internal::SecondScale, units_internal::TimeTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "s"; }
+};
+template <>
+struct TagSuffix<units_internal::MillisecondScale, units_internal::TimeTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "ms"; }
+};
+template <>
+struct TagSuffix<units_internal::GrayPerSecondScale, 
+                 units_internal::DoseRateTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "Gy/s"; }
+};
+template <>
+struct TagSuffix<units_internal::DegreePerSecondScale, 
+                 units_internal::AngularVelocityTag> {
+  NO_DISCARD static constexpr const char* c_str() noexcept { return "deg/s"; }
+};
+
+// Compile-time lists of the (scale, tag) pairs that have a suffix string. 
+// Used to map suffix strings back to unit types when parsing.
+template <typename ScaleT, typename TagT>
+struct ScaleTagPair {
+  using ScaleType = ScaleT;
+  using TagType = TagT;
+};
+
+template <typename... Ts>
+struct TypeList {};
+
+template <typename ListT>
+struct TypeListSize;
+template <typename... Ts>
+struct TypeListSize<TypeList<Ts...>>
+    : public std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <std::size_t I, typename ListT>
+struct TypeAt;
+template <typename T, typename... Ts>
+struct TypeAt<0, TypeList<T, Ts...>> {
+  using type = T;
+};
+template <std::size_t I, typename T, typename... Ts>
+struct TypeAt<I, TypeList<T, Ts...>> {
+  using type = typename TypeAt<I - 1, TypeList<Ts...>>::type;
+};
+template <std::size_t I, typename ListT>
+using TypeAtT = typename TypeAt<I, ListT>::type;
+
+template <typename... ListTs>
+struct TypeListConcat;
+template <>
+struct TypeListConcat<> {
+  using type = TypeList<>;
+};
+template <typename... Ts>
+struct TypeListConcat<TypeList<Ts...>> {
+  using type = TypeList<Ts...>;
+};
+template <typename... Ts, typename... Us, typename... ListTs>
+struct TypeListConcat<TypeList<Ts...>, TypeList<Us...>, ListTs...> {
+  using type = typename TypeListConcat<TypeList<Ts..., Us...>, ListTs...>::type;
+};
+
+// Scales that have suffixes, per tag. The built-in lists are closed, 
+// scales for new tags (or additional scales for built-in tags) are added
+// by specializing UserTagScales, see THINKS_UNITS_TAG_SCALES.
+template <typename TagT>
+struct BuiltinTagScales {
+  using type = TypeList<>;
+};
+template <>
+struct BuiltinTagScales<LengthTag> {
+  using type = TypeList<MeterScale, CentimeterScale, MillimeterScale>;
+};
+template <>
+struct BuiltinTagScales<AreaTag> {
+  using type = TypeList<SquareMeterScale, SquareCentimeterScale, 
+                        SquareMillimeterScale>;
+};
+template <>
+struct BuiltinTagScales<VolumeTag> {
+  using type = TypeList<CubicCentimeterScale, CubicMillimeterScale>;
+};
+template <>
+struct BuiltinTagScales<AngleTag> {
+  using type = TypeList<DegreeScale, RadianScale>;
+};
+template <>
+struct BuiltinTagScales<DoseTag> {
+  using type = TypeList<GrayScale, CentiGrayScale>;
+};
+template <>
+struct BuiltinTagScales<TimeTag> {
+  using type = TypeList<SecondScale, MillisecondScale>;
+};
+template <>
+struct BuiltinTagScales<DoseRateTag> {
+  using type = TypeList<GrayPerSecondScale>;
+};
+template <>
+struct BuiltinTagScales<AngularVelocityTag> {
+  using type = TypeList<DegreePerSecondScale>;
+};
+
+template <typename TagT>
+struct UserTagScales {
+  using type = TypeList<>;
+};
+
+template <typename TagT>
+using TagScales = typename TypeListConcat<
+    typename BuiltinTagScales<TagT>::type, 
+    typename UserTagScales<TagT>::type>::type;
+
+// Tags that are searched when the tag is not known up front, i.e. when 
+// parsing strings at compile-time. New tags are added by specializing 
+// UserTags<void>, see THINKS_UNITS_USER_TAGS.
+using BuiltinTags = TypeList<LengthTag, AreaTag, VolumeTag, AngleTag, DoseTag,
+                             TimeTag, DoseRateTag, AngularVelocityTag>;
+
+template <typename T>
+struct UserTags {
+  using type = TypeList<>;
+};
+
+template <typename TagT, typename ScalesT>
+struct PairsForTag;
+template <typename TagT, typename... ScaleTs>
+struct PairsForTag<TagT, TypeList<ScaleTs...>> {
+  using type = TypeList<ScaleTagPair<ScaleTs, TagT>...>;
+};
+
+template <typename TagsT>
+struct PairsForTags;
+template <typename... TagTs>
+struct PairsForTags<TypeList<TagTs...>> {
+  using type = typename TypeListConcat<
+      typename PairsForTag<TagTs, TagScales<TagTs>>::type...>::type;
+};
+
+// All (scale, tag) pairs with suffixes. The template parameter only 
+// serves to delay instantiation until the point of use, such that user
+// specializations declared after this header are picked up.
+template <typename T = void>
+using SuffixedUnits = typename PairsForTags<typename TypeListConcat<
+    BuiltinTags, 
+    typename UserTags<std::enable_if_t<sizeof(T*) != 0>>::type>::type>::type;
+
+// Whitespace allowed around values and suffixes in unit strings.
+NO_DISCARD constexpr bool IsSpace(const char c) noexcept {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+NO_DISCARD constexpr bool IsDigit(const char c) noexcept {
+  return '0' <= c && c <= '9';
+}
+
+NO_DISCARD constexpr auto SuffixEquals(const char* suffix, const char* first,
+                                       const std::size_t len) noexcept 
+    -> bool {
+  for (std::size_t i = 0; i < len; ++i) {
+    if (suffix[i] == '\0' || suffix[i] != first[i]) {
+      return false;
+    }
+  }
+  return suffix[len] == '\0';
+}
+
+// Returns the index in the list of the pair whose suffix string matches
+// [first, first + len), or the size of the list if there is no match.
+template <typename... Ps>
+NO_DISCARD constexpr auto FindSuffix(TypeList<Ps...>, const char* first,
+                                     const std::size_t len) noexcept 
+    -> std::size_t {
+  constexpr const char* suffixes[] = {
+      TagSuffix<typename Ps::ScaleType, typename Ps::TagType>::c_str()...};
+  for (std::size_t i = 0; i < sizeof...(Ps); ++i) {
+    if (SuffixEquals(suffixes[i], first, len)) {
+      return i;
+    }
+  }
+  return sizeof...(Ps);
+}
+
+// Value types for units created using literals.
+using LiteralFloatType = double; // literal: long double
+using LiteralIntType = long long; // literal: unsigned long long
+
+}  // namespace units_internal
+
+template <typename ArithT, typename ScaleT, typename TagT>
+#if THINKS_UNITS_HAS_CONCEPTS
+  requires units_internal::arithmetic<ArithT> && 
+           units_internal::scale<ScaleT> && units_internal::tag<TagT>
+#endif
+class Unit;
+
+// Forward declaration, unit_cast is used by Unit operators.
+template <typename ToUnitT, 
+          typename FromArithT, typename FromScaleT, typename TagT>
+constexpr auto unit_cast(const Unit<FromArithT, FromScaleT, TagT> from) 
+    -> Unit<typename ToUnitT::ValueType, typename ToUnitT::ScaleType, TagT>;
+
+namespace units_internal {
+
+// Result of multiplying or dividing units. Dimensionless results are
+// returned as scalars, with the scale applied.
+template <typename ScaleT, typename TagT, typename ArithT>
+NO_DISCARD constexpr auto MakeUnit(const ArithT v) noexcept {
+  if constexpr (std::is_same_v<TagT, Dimensionless>) {
+    return ScaleHelper<ScaleT, std::ratio<1>>::template Scale<ArithT>(v);
+  } else {
+    return Unit<ArithT, ScaleT, TagT>{ArithT{v}};
+  }
+}
+
+}  // namespace units_internal
+
+// Template that can be customized to hold a value representing
+// a unit of some sort, e.g. centimeters, radians, etc.
+template <typename ArithT, typename ScaleT, typename TagT>
+#if THINKS_UNITS_HAS_CONCEPTS
+  requires units_internal::arithmetic<ArithT> && 
+           units_internal::scale<ScaleT> && units_internal::tag<TagT>
+#endif
+class Unit {
+#if !THINKS_UNITS_HAS_CONCEPTS
+  static_assert(std::is_arithmetic_v<ArithT>, "ArithT must be arithmetic");
+  static_assert(units_internal::is_scale_v<ScaleT>, "ScaleT must be a scale");
+  static_assert(units_internal::is_tag_v<TagT>, "TagT must be a tag");
+#endif
+  ArithT value_;
+
+ public:
+  using ValueType = ArithT;
+  using ScaleType = ScaleT;
+  using TagType = TagT;
+
+  // Ctor.
+  //
+  // NOTE(thinks):
+  //   ctor not explicit here since copy-list-initialization cannot 
+  //   use explicit constructors (C++14).
+  // clang-format off
+  /*explicit*/ constexpr Unit(ValueType&& v) 
+    //noexcept(noexcept(ValueType{std::move(v)}))
+      : value_{std::move(v)} {}
+  // clang-format on    
+
+  NO_DISCARD constexpr ValueType value() const noexcept { return value_; }
+
+  // Add a unit.
+  // Supports different scales since there is no ambiguity in return type.
+  template<typename ArithT2, typename ScaleT2>
+  constexpr auto operator+=(const Unit<ArithT2, ScaleT2, TagT> rhs) 
+      // TODO(thinks): noexcept
+      -> Unit& {
+    value_ += unit_cast<Unit>(rhs).value();
+    return *this;
+  }
+
+  // Subtract a unit.
+  // Supports different scales since there is no ambiguity in return type.
+  template<typename ArithT2, typename ScaleT2>
+  constexpr auto operator-=(const Unit<ArithT2, ScaleT2, TagT> rhs) 
+      // TODO(thinks): noexcept
+      -> Unit& {
+    value_ -= unit_cast<Unit>(rhs).value();
+    return *this;
+  }
+
+  // Multiply by a scalar.
+  // Here we consider the scalar to be dimension-less such that 
+  // multiplication with the underlying value preserves the unit
+  // dimension.
+#if THINKS_UNITS_HAS_CONCEPTS
+  template <units_internal::arithmetic ArithT2>
+#else
+  template <typename ArithT2,
+            typename = std::enable_if_t<std::is_arithmetic_v<ArithT2>>>
+#endif
+  constexpr auto operator*=(const ArithT2 rhs) 
+      // TODO(thinks): noexcept
+      -> Unit& {
+    value_ *= rhs;    
+    return *this;
+  } 
+
+  // Divide by a scalar.
+  // Here we consider the scalar to be dimension-less such that 
+  // multiplication with the underlying value preserves the unit
+  // dimension.
+#if THINKS_UNITS_HAS_CONCEPTS
+  template <units_internal::arithmetic ArithT2>
+#else
+  template <typename ArithT2,
+            typename = std::enable_if_t<std::is_arithmetic_v<ArithT2>>>
+#endif
+  constexpr auto operator/=(const ArithT2 rhs) 
+      // TODO(thinks): noexcept
+      -> Unit& {
+    value_ /= rhs;    
+    return *this;
+  }
+};
+
+// Operators are defined at namespace scope rather than as hidden friends.
+// Each instantiation of a class template injects its friends into the 
+// enclosing namespace, which makes overload resolution scale with the
+// number of unit types used in a translation unit.
+
+// Equality comparison of same-tag-units with different value
+// type and/or scale. Normal comparison rules for arithmetic types apply.
+//
+// Allowing units of different scale here since there is no ambiguity in
+// return type. Neither side is truncated, so integer comparisons across
+// scales are exact and symmetric.
+//
+// clang-format off
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator==(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) == CompareT::Rhs(rhs.value());
+}
+// clang-format on
+
+// Inequality comparison of same-tag-units with different value
+// type and/or scale. Normal comparison rules for arithmetic types apply.
+//
+// Allowing units of different scale here since there is no ambiguity in
+// return type.
+//
+// clang-format off
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator!=(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) != CompareT::Rhs(rhs.value());
+}
+// clang-format on
+
+// Ordering of same-tag-units with different value type and/or scale.
+// Values are compared in place, without converting both sides to a
+// common unit first, see CompareHelper.
+//
+// clang-format off
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator<(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) < CompareT::Rhs(rhs.value());
+}
+
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator<=(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) <= CompareT::Rhs(rhs.value());
+}
+
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator>(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) > CompareT::Rhs(rhs.value());
+}
+
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator>=(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept -> bool {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) >= CompareT::Rhs(rhs.value());
+}
+
+#if defined(__cpp_impl_three_way_comparison) && \
+    defined(__cpp_lib_three_way_comparison)
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator<=>(const Unit<ArithT1, ScaleT1, TagT> lhs,
+                          const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    noexcept {
+  using CompareT = 
+      units_internal::CompareHelper<ScaleT1, ScaleT2, ArithT1, ArithT2>;
+  return CompareT::Lhs(lhs.value()) <=> CompareT::Rhs(rhs.value());
+}
+#endif
+// clang-format on
+
+// Unary negation.
+// The value type of the returned unit follows normal arithmetic promotion.
+//
+// clang-format off
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD
+constexpr auto operator-(const Unit<ArithT, ScaleT, TagT> u)
+    //noexcept(noexcept(-u.value())) 
+    -> Unit<decltype(-u.value()), ScaleT, TagT> {
+  return {-u.value()};
+}
+// clang-format on
+
+// Binary subtraction.
+// Supports different value types.
+// The value type of the returned unit follows normal arithmetic promotion.
+//
+// Requires the units to have the same scale factor, since the return type
+// would otherwise be ambiguous.
+//
+// clang-format off
+template <typename ArithT1, typename ArithT2, typename ScaleT, typename TagT>
+NO_DISCARD
+constexpr auto operator-(const Unit<ArithT1, ScaleT, TagT> lhs,
+                         const Unit<ArithT2, ScaleT, TagT> rhs) 
+    //noexcept(noexcept(lhs.value() - rhs.value()))
+    -> Unit<decltype(lhs.value() - rhs.value()), ScaleT, TagT> {
+  return {lhs.value() - rhs.value()};
+}
+// clang-format on
+
+// Binary addition.
+// Supports different value types.
+// The value type of the returned unit follows normal arithmetic promotion.
+//
+// Requires the units to have the same scale factor, since the return type
+// would otherwise be ambiguous.
+//
+// clang-format off
+template <typename ArithT1, typename ArithT2, typename ScaleT, typename TagT>
+NO_DISCARD
+constexpr auto operator+(const Unit<ArithT1, ScaleT, TagT> lhs,
+                         const Unit<ArithT2, ScaleT, TagT> rhs) 
+    //noexcept(noexcept(lhs.value() + rhs.value()))
+    -> Unit<decltype(lhs.value() + rhs.value()), ScaleT, TagT> {
+  return {lhs.value() + rhs.value()};
+}
+// clang-format on
+
+// Multiply by scalar (rhs). 
+// Preserves multiplicative ordering.
+// The value type of the returned unit follows normal arithmetic promotion.
+// 
+// clang-format off
+#if THINKS_UNITS_HAS_CONCEPTS
+template <typename ArithT1, typename ScaleT, typename TagT, 
+          units_internal::arithmetic ArithT2>
+#else
+template <typename ArithT1, typename ScaleT, typename TagT, typename ArithT2,
+          typename = std::enable_if_t<std::is_arithmetic_v<ArithT2>>>
+#endif
+NO_DISCARD
+constexpr auto operator*(const Unit<ArithT1, ScaleT, TagT> lhs,
+                         const ArithT2 rhs) 
+    // noexcept...
+    -> Unit<decltype(lhs.value() * rhs), ScaleT, TagT> {
+  return {lhs.value() * rhs};    
+}
+// clang-format on
+
+// Multiply by scalar (lhs).  
+// Preserves multiplicative ordering.
+// The value type of the returned unit follows normal arithmetic promotion.
+// 
+// clang-format off
+#if THINKS_UNITS_HAS_CONCEPTS
+template <typename ArithT1, typename ScaleT, typename TagT, 
+          units_internal::arithmetic ArithT2>
+#else
+template <typename ArithT1, typename ScaleT, typename TagT, typename ArithT2,
+          typename = std::enable_if_t<std::is_arithmetic_v<ArithT2>>>
+#endif
+NO_DISCARD
+constexpr auto operator*(const ArithT2 lhs,
+                         const Unit<ArithT1, ScaleT, TagT> rhs) 
+    // noexcept...
+    -> Unit<decltype(lhs * rhs.value()), ScaleT, TagT> {
+  return {lhs * rhs.value()};
+}
+// clang-format on
+
+// Divide two same-tag-units to produce a scalar value.
+// Essentially, dimensionality is cancelled out by this operation.
+//
+// Allowing units of different scale here since there is no ambiguity in
+// return type, which is a scalar.
+// 
+// clang-format off
+template <typename ArithT1, typename ScaleT1, 
+          typename ArithT2, typename ScaleT2, typename TagT>
+NO_DISCARD
+constexpr auto operator/(const Unit<ArithT1, ScaleT1, TagT> lhs, 
+                         const Unit<ArithT2, ScaleT2, TagT> rhs) 
+    // noexcept...
+    -> decltype(lhs.value() / unit_cast<Unit<ArithT1, ScaleT1, TagT>>(rhs).value()) {
+  return lhs.value() / unit_cast<Unit<ArithT1, ScaleT1, TagT>>(rhs).value();
+}
+// clang-format on
+
+// Divide by scalar, preserves unit dimensionality.
+// 
+// clang-format off
+#if THINKS_UNITS_HAS_CONCEPTS
+template <typename ArithT1, typename ScaleT, typename TagT, 
+          units_internal::arithmetic ArithT2>
+#else
+template <typename ArithT1, typename ScaleT, typename TagT, typename ArithT2,
+          typename = std::enable_if_t<std::is_arithmetic_v<ArithT2>>>
+#endif
+NO_DISCARD
+constexpr auto operator/(const Unit<ArithT1, ScaleT, TagT> lhs, 
+                         const ArithT2 rhs) 
+    // noexcept...
+    -> Unit<decltype(lhs.value() / rhs), ScaleT, TagT> {
+  return {lhs.value() / rhs};
+}
+// clang-format on
+
+// Multiply two units to produce a unit of the combined dimension, 
+// e.g. [mm] * [mm] -> [mm^2]. 
+//
+// The scale of the result is the product of the scales, so the 
+// returned value is simply the product of the values and no conversion
+// takes place at run-time. If the dimensions cancel out the result is 
+// a scalar.
+//
+// clang-format off
+template <typename ArithT1, typename ScaleT1, typename TagT1,
+          typename ArithT2, typename ScaleT2, typename TagT2>
+NO_DISCARD
+constexpr auto operator*(const Unit<ArithT1, ScaleT1, TagT1> lhs,
+                         const Unit<ArithT2, ScaleT2, TagT2> rhs) 
+    // noexcept...
+{
+  using ScaleT3 = units_internal::ScaleMultiply<ScaleT1, ScaleT2>;
+  using TagT3 = units_internal::DimensionMultiply<TagT1, TagT2>;
+  return units_internal::MakeUnit<ScaleT3, TagT3>(lhs.value() * rhs.value());
+}
+// clang-format on
+
+// Divide two units with different tags to produce a unit of the derived 
+// dimension, e.g. [Gy] / [s] -> [Gy/s]. Same rules as multiplication, 
+// the scale of the result is the quotient of the scales.
+//
+// clang-format off
+#if THINKS_UNITS_HAS_CONCEPTS
+template <typename ArithT1, typename ScaleT1, typename TagT1,
+          typename ArithT2, typename ScaleT2, typename TagT2>
+  requires (!std::is_same_v<TagT1, TagT2>)
+#else
+template <typename ArithT1, typename ScaleT1, typename TagT1,
+          typename ArithT2, typename ScaleT2, typename TagT2,
+          typename = std::enable_if_t<!std::is_same_v<TagT1, TagT2>>>
+#endif
+NO_DISCARD
+constexpr auto operator/(const Unit<ArithT1, ScaleT1, TagT1> lhs,
+                         const Unit<ArithT2, ScaleT2, TagT2> rhs) 
+    // noexcept...
+{
+  using ScaleT3 = units_internal::ScaleDivide<ScaleT1, ScaleT2>;
+  using TagT3 = units_internal::DimensionDivide<TagT1, TagT2>;
+  return units_internal::MakeUnit<ScaleT3, TagT3>(lhs.value() / rhs.value());
+}
+// clang-format on
+
+
+// Convert between units with the same tag that have potentially different
+// scale factors and value types.
+//
+// clang-format off
+template <typename ToUnitT, 
+          typename FromArithT, typename FromScaleT, typename TagT>
+NO_DISCARD          
+constexpr auto unit_cast(const Unit<FromArithT, FromScaleT, TagT> from) 
+    //noexcept(noexcept(
+    //  units_internal::ScaleHelper<FromScaleT, typename ToUnitT::ScaleType>::
+    //    Scale<typename ToUnitT::ValueType>(from.value())))
+    -> Unit<typename ToUnitT::ValueType, typename ToUnitT::ScaleType, TagT> {
+  static_assert(std::is_same_v<typename ToUnitT::TagType, TagT>,
+                "units must have same tag");
+  using ToScaleT = typename ToUnitT::ScaleType;
+  using ScaleHelper = units_internal::ScaleHelper<FromScaleT, ToScaleT>;
+  return {ScaleHelper::template Scale<typename ToUnitT::ValueType>(from.value())};
+}
+
+// Convert an array of units, e.g. a dose grid, writing count units to
+// the output array. The scale factor is the same for all elements, 
+// such that the loop can be vectorized.
+template <typename FromArithT, typename FromScaleT, 
+          typename ToArithT, typename ToScaleT, typename TagT>
+void unit_cast(const Unit<FromArithT, FromScaleT, TagT>* from, 
+               const std::size_t count,
+               Unit<ToArithT, ToScaleT, TagT>* to) {
+  using ToUnitT = Unit<ToArithT, ToScaleT, TagT>;
+  for (std::size_t i = 0; i < count; ++i) {
+    to[i] = unit_cast<ToUnitT>(from[i]);
+  }
+}
+// clang-format on
+
+// Define user-visible types.
+//
+// clang-format off
+template <typename ArithT> using Meters = Unit<ArithT, units_internal::MeterScale, units_internal::LengthTag>; 
+template <typename ArithT> using Centimeters = Unit<ArithT, units_internal::CentimeterScale, units_internal::LengthTag>; 
+template <typename ArithT> using Millimeters = Unit<ArithT, units_internal::MillimeterScale, units_internal::LengthTag>;
+
+template <typename ArithT> using SquareMeters = Unit<ArithT, units_internal::SquareMeterScale, units_internal::AreaTag>; 
+template <typename ArithT> using SquareCentimeters = Unit<ArithT, units_internal::SquareCentimeterScale, units_internal::AreaTag>; 
+template <typename ArithT> using SquareMillimeters = Unit<ArithT, units_internal::SquareMillimeterScale, units_internal::AreaTag>; 
+template <typename ArithT> using CubicCentimeters = Unit<ArithT, units_internal::CubicCentimeterScale, units_internal::VolumeTag>; 
+template <typename ArithT> using CubicMillimeters = Unit<ArithT, units_internal::CubicMillimeterScale, units_internal::VolumeTag>; 
+
+template <typename ArithT> using Degrees = Unit<ArithT, units_internal::DegreeScale, units_internal::AngleTag>; 
+template <typename ArithT> using Radians = Unit<ArithT, units_internal::RadianScale, units_internal::AngleTag>; 
+
+template <typename ArithT> using Gray = Unit<ArithT, units_internal::GrayScale, units_internal::DoseTag>; 
+template <typename ArithT> using CentiGray = Unit<ArithT, units_internal::CentiGrayScale, units_internal::DoseTag>; 
+
+template <typename ArithT> using Seconds = Unit<ArithT, units_internal::SecondScale, units_internal::TimeTag>; 
+template <typename ArithT> using Milliseconds = Unit<ArithT, units_internal::MillisecondScale, units_internal::TimeTag>; 
+
+template <typename ArithT> using GrayPerSecond = Unit<ArithT, units_internal::GrayPerSecondScale, units_internal::DoseRateTag>; 
+template <typename ArithT> using DegreesPerSecond = Unit<ArithT, units_internal::DegreePerSecondScale, units_internal::AngularVelocityTag>; 
+// clang-format on
+
+// Bridging to std::chrono. Time scales are expressed in seconds, same as
+// std::chrono::duration periods, so conversions in both directions keep
+// the value (and value type) as is and have no run-time cost. Use 
+// unit_cast or std::chrono::duration_cast to change the scale.
+//
+// clang-format off
+template <typename Rep, typename Period>
+NO_DISCARD constexpr auto from_duration(
+    const std::chrono::duration<Rep, Period> d) noexcept
+    -> Unit<Rep, typename Period::type, units_internal::TimeTag> {
+  return {d.count()};
+}
+
+template <typename ArithT, typename ScaleT>
+NO_DISCARD constexpr auto to_duration(
+    const Unit<ArithT, ScaleT, units_internal::TimeTag> u) noexcept
+    -> std::chrono::duration<ArithT, ScaleT> {
+  return std::chrono::duration<ArithT, ScaleT>{u.value()};
+}
+
+// Multiplying or dividing by a duration is the same as multiplying or 
+// dividing by the corresponding time unit, e.g. a dose rate times a 
+// duration is a dose.
+template <typename ArithT, typename ScaleT, typename TagT, 
+          typename Rep, typename Period>
+NO_DISCARD constexpr auto operator*(
+    const Unit<ArithT, ScaleT, TagT> lhs,
+    const std::chrono::duration<Rep, Period> rhs) noexcept {
+  return lhs * from_duration(rhs);
+}
+
+template <typename ArithT, typename ScaleT, typename TagT, 
+          typename Rep, typename Period>
+NO_DISCARD constexpr auto operator*(
+    const std::chrono::duration<Rep, Period> lhs,
+    const Unit<ArithT, ScaleT, TagT> rhs) noexcept {
+  return from_duration(lhs) * rhs;
+}
+
+template <typename ArithT, typename ScaleT, typename TagT, 
+          typename Rep, typename Period>
+NO_DISCARD constexpr auto operator/(
+    const Unit<ArithT, ScaleT, TagT> lhs,
+    const std::chrono::duration<Rep, Period> rhs) noexcept {
+  return lhs / from_duration(rhs);
+}
+// clang-format on
+
+// Tag for a single base dimension, e.g. for user-defined base dimensions.
+template <typename BaseT>
+using BaseTag = units_internal::Dimension<units_internal::Power<BaseT, 1>>;
+
+#undef NO_DISCARD
+
+}  // namespace thinks
+
+// Registration of user-defined tags, scales, suffixes and literals, such 
+// that I/O, parsing, serialization and conversions work the same as for 
+// the built-in units. Except for THINKS_UNITS_LITERAL (see 
+// units_literals.h), these macros 
+// specialize templates in this library and must be used at global 
+// namespace scope. Arguments containing commas, such as std::ratio<1, 10>,
+// should be given as type aliases. Example:
+//
+//   struct MassBase;
+//   THINKS_UNITS_BASE_DIMENSION(MassBase, "mass")
+//   using MassTag = thinks::BaseTag<MassBase>;
+//   using KilogramScale = std::ratio<1>::type;
+//   using GramScale = std::ratio<1, 1000>::type;
+//   THINKS_UNITS_SUFFIX(KilogramScale, MassTag, "kg")
+//   THINKS_UNITS_SUFFIX(GramScale, MassTag, "g")
+//   THINKS_UNITS_TAG_SCALES(MassTag, KilogramScale, GramScale)
+//   THINKS_UNITS_USER_TAGS(MassTag)
+//
+//   template <typename ArithT> 
+//   using Kilograms = thinks::Unit<ArithT, KilogramScale, MassTag>;
+//   namespace my_literals { THINKS_UNITS_LITERAL(Kilograms, _kg) }
+
+// Name of a base dimension, must be unique.
+#define THINKS_UNITS_BASE_DIMENSION(BaseT, name)                      \
+  template <>                                                        \
+  struct thinks::units_internal::BaseName<BaseT> {                   \
+    static constexpr const char* c_str() noexcept { return name; }   \
+  };
+
+// Suffix used for I/O of units with the given scale and tag.
+#define THINKS_UNITS_SUFFIX(ScaleT, TagT, suffix)                     \
+  template <>                                                        \
+  struct thinks::units_internal::TagSuffix<ScaleT, TagT> {           \
+    static constexpr const char* c_str() noexcept { return suffix; } \
+  };
+
+// Scales (with suffixes) that parsing considers for a tag. For built-in
+// tags the scales are added to the built-in ones. At most once per tag.
+#define THINKS_UNITS_TAG_SCALES(TagT, ...)                               \
+  template <>                                                           \
+  struct thinks::units_internal::UserTagScales<TagT> {                  \
+    using type = thinks::units_internal::TypeList<__VA_ARGS__>;          \
+  };
+
+// Tags that compile-time parsing (thinks::parse) considers in addition 
+// to the built-in ones. At most once per program.
+#define THINKS_UNITS_USER_TAGS(...)                                   \
+  template <>                                                        \
+  struct thinks::units_internal::UserTags<void> {                    \
+    using type = thinks::units_internal::TypeList<__VA_ARGS__>;       \
+  };
+
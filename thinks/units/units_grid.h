@@ -0,0 +1,140 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Grids of units that are accumulated into from multiple threads.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "thinks/units/units_core.h"
+#include "thinks/units/units_parallel.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+// Grid where each thread accumulates into its own private copy, avoiding
+// contended atomics (cf. AtomicUnit). The private copies are split into
+// tiles that are allocated when a thread first adds to a voxel in the
+// tile, such that memory use is proportional to the voxels touched by
+// each thread. The private copies are summed into an output grid by
+// merge, which may use a different scale (e.g. centigray tallies merged
+// into a gray grid).
+//
+// Threads are identified by indices in [0, thread_count). Different
+// threads may call add concurrently, but a thread index must only be
+// used by one thread at a time.
+template <typename UnitT>
+class PrivatizedGrid {
+ public:
+  using UnitType = UnitT;
+  using ValueType = typename UnitT::ValueType;
+
+  static constexpr std::size_t kDefaultTileSize = 4096;
+
+  PrivatizedGrid(const std::size_t voxel_count, const unsigned thread_count,
+                 const std::size_t tile_size = kDefaultTileSize)
+      : voxel_count_{voxel_count},
+        tile_size_{std::max(tile_size, std::size_t{1})},
+        tile_count_{(voxel_count + tile_size_ - 1) / tile_size_},
+        tiles_(thread_count, std::vector<std::vector<UnitT>>(tile_count_)) {}
+
+  NO_DISCARD auto voxel_count() const noexcept -> std::size_t {
+    return voxel_count_;
+  }
+
+  NO_DISCARD auto thread_count() const noexcept -> unsigned {
+    return static_cast<unsigned>(tiles_.size());
+  }
+
+  NO_DISCARD auto tile_size() const noexcept -> std::size_t {
+    return tile_size_;
+  }
+
+  // Number of tiles allocated by all threads.
+  NO_DISCARD auto allocated_tile_count() const noexcept -> std::size_t {
+    std::size_t n = 0;
+    for (const auto& thread_tiles : tiles_) {
+      for (const auto& tile : thread_tiles) {
+        n += tile.empty() ? 0 : 1;
+      }
+    }
+    return n;
+  }
+
+  // Add a unit with the same tag to a voxel in the private copy of the
+  // given thread, units with different scales are converted.
+  template <typename ArithT2, typename ScaleT2>
+  void add(const unsigned thread_index, const std::size_t voxel,
+           const Unit<ArithT2, ScaleT2, typename UnitT::TagType> u) {
+    auto& tile = tiles_[thread_index][voxel / tile_size_];
+    if (tile.empty()) {
+      tile.assign(tile_size_, UnitT{ValueType{0}});
+    }
+    tile[voxel % tile_size_] += u;
+  }
+
+  // Add the private copies of all threads to the output grid, which
+  // must hold voxel_count units with the same tag. The output grid is
+  // processed one tile at a time, such that it stays in cache while the
+  // private tiles are added. The private copies are summed in thread
+  // index order, such that results do not depend on the policy.
+  template <typename PolicyT, typename OutArithT, typename OutScaleT>
+  void merge(PolicyT&& policy,
+             Unit<OutArithT, OutScaleT, typename UnitT::TagType>* out) const {
+    using OutUnitT = Unit<OutArithT, OutScaleT, typename UnitT::TagType>;
+    const auto merge_tiles = [&](const std::size_t, const std::size_t begin,
+                                 const std::size_t end) {
+      std::vector<OutUnitT> converted(tile_size_, OutUnitT{OutArithT{0}});
+      for (std::size_t k = begin; k < end; ++k) {
+        const auto first = k * tile_size_;
+        const auto n = std::min(tile_size_, voxel_count_ - first);
+        for (const auto& thread_tiles : tiles_) {
+          const auto& tile = thread_tiles[k];
+          if (tile.empty()) {
+            continue;
+          }
+          unit_cast(tile.data(), n, converted.data());
+          for (std::size_t i = 0; i < n; ++i) {
+            out[first + i] += converted[i];
+          }
+        }
+      }
+    };
+    units_internal::ChunkedFor(policy, tile_count_, voxel_count_,
+                               merge_tiles);
+  }
+  template <typename OutArithT, typename OutScaleT>
+  void merge(Unit<OutArithT, OutScaleT, typename UnitT::TagType>* out) const {
+    merge(execution::seq, out);
+  }
+
+  // Release all private tiles.
+  void clear() noexcept {
+    for (auto& thread_tiles : tiles_) {
+      for (auto& tile : thread_tiles) {
+        std::vector<UnitT>{}.swap(tile);
+      }
+    }
+  }
+
+ private:
+  std::size_t voxel_count_;
+  std::size_t tile_size_;
+  std::size_t tile_count_;
+
+  // Tiles per thread, empty until first touched.
+  std::vector<std::vector<std::vector<UnitT>>> tiles_;
+};
+
+#undef NO_DISCARD
+
+}  // namespace thinks
@@ -0,0 +1,14 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Explicit instantiations for the thinks_units_inst library, see
+// THINKS_UNITS_IO_INSTANTIATE_COMMON in units_io.h.
+
+#include "thinks/units/units_io.h"
+
+namespace thinks {
+
+THINKS_UNITS_IO_INSTANTIATE_COMMON()
+
+}  // namespace thinks
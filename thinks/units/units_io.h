@@ -0,0 +1,694 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Text and binary I/O of units.
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+// Simple output overload, prints unit suffix after value.
+// Formatting of the value depends on the locale and flags of the stream,
+// see to_chars for a locale-independent alternative.
+//
+// clang-format off
+template <typename ArithT, typename ScaleT, typename TagT>
+std::ostream& operator<<(std::ostream& os,
+                         const Unit<ArithT, ScaleT, TagT>& rhs) {
+  os << rhs.value() 
+     << " [" << units_internal::TagSuffix<ScaleT, TagT>::c_str() << "]";
+  return os;
+}
+// clang-format on
+
+namespace units_internal {
+
+// 64-bit FNV-1a hashing, usable at compile-time.
+inline constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+inline constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+NO_DISCARD constexpr auto FnvAppend(const std::uint64_t h, 
+                                    const unsigned char b) noexcept 
+    -> std::uint64_t {
+  return (h ^ b) * kFnvPrime;
+}
+
+NO_DISCARD constexpr auto FnvAppend(std::uint64_t h, 
+                                    const char* s) noexcept 
+    -> std::uint64_t {
+  // Include the terminating null so that adjacent strings cannot alias.
+  do {
+    h = FnvAppend(h, static_cast<unsigned char>(*s));
+  } while (*s++ != '\0');
+  return h;
+}
+
+NO_DISCARD constexpr auto FnvAppend(std::uint64_t h, 
+                                    const std::intmax_t v) noexcept 
+    -> std::uint64_t {
+  // Little-endian byte order, independent of the host.
+  const auto u = static_cast<std::uint64_t>(v);
+  for (int i = 0; i < 8; ++i) {
+    h = FnvAppend(h, static_cast<unsigned char>((u >> (8 * i)) & 0xff));
+  }
+  return h;
+}
+
+template <typename... Ps>
+NO_DISCARD constexpr auto FnvAppend(std::uint64_t h, Dimension<Ps...>) noexcept 
+    -> std::uint64_t {
+  ((h = FnvAppend(FnvAppend(h, BaseName<typename Ps::BaseType>::c_str()),
+                  std::intmax_t{Ps::exponent})), ...);
+  return h;
+}
+
+// Identifies a unit type using only information that is stable across
+// compilers and platforms: base names and exponents, scale ratio and the
+// kind and size of the value type. Floating point types also include
+// their format, since e.g. long double is an 80-bit extended type on
+// x86-64 but a 128-bit quadruple precision type on AArch64.
+template <typename UnitT>
+NO_DISCARD constexpr auto UnitFingerprint() noexcept -> std::uint64_t {
+  using ValueType = typename UnitT::ValueType;
+  using ScaleType = typename UnitT::ScaleType;
+  auto h = FnvAppend(kFnvOffsetBasis, typename UnitT::TagType{});
+  h = FnvAppend(h, ScaleTraits<ScaleType>::RatioType::num);
+  h = FnvAppend(h, ScaleTraits<ScaleType>::RatioType::den);
+  if (ScaleTraits<ScaleType>::pi_exponent != 0) {
+    h = FnvAppend(h, std::intmax_t{ScaleTraits<ScaleType>::pi_exponent});
+  }
+  h = FnvAppend(h, static_cast<unsigned char>(
+                       std::is_same_v<ValueType, bool> ? 'b' :
+                       std::is_floating_point_v<ValueType> ? 'f' : 
+                       std::is_signed_v<ValueType> ? 'i' : 'u'));
+  h = FnvAppend(h, static_cast<unsigned char>(sizeof(ValueType)));
+  if (std::is_floating_point_v<ValueType>) {
+    h = FnvAppend(h, std::intmax_t{std::numeric_limits<ValueType>::digits});
+    h = FnvAppend(
+        h, std::intmax_t{std::numeric_limits<ValueType>::max_exponent});
+  }
+  return h;
+}
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+inline constexpr bool kLittleEndianHost = false;
+#else
+inline constexpr bool kLittleEndianHost = true;
+#endif
+
+// Copy 'n' bytes between host and little-endian byte order. The same 
+// operation works in both directions.
+inline void CopyLittleEndian(unsigned char* dst, const unsigned char* src, 
+                             const std::size_t n) noexcept {
+  if (kLittleEndianHost) {
+    std::memcpy(dst, src, n);
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] = src[n - 1 - i];
+    }
+  }
+}
+
+// Serialized header: [fingerprint: 8 bytes][count: 8 bytes], both 
+// stored as little-endian.
+inline constexpr std::size_t kSerializedHeaderSize = 16;
+
+}  // namespace units_internal
+
+// Compile-time fingerprint of a unit type. Units that differ in tag, 
+// scale or value type have different fingerprints.
+template <typename UnitT>
+constexpr std::uint64_t unit_fingerprint_v =
+    units_internal::UnitFingerprint<UnitT>();
+
+// Number of bytes required to serialize 'count' units of type UnitT.
+template <typename UnitT>
+NO_DISCARD constexpr auto serialized_size(const std::size_t count) noexcept
+    -> std::size_t {
+  return units_internal::kSerializedHeaderSize + 
+         count * sizeof(typename UnitT::ValueType);
+}
+
+// Write 'count' units as a fingerprint header followed by raw 
+// little-endian values. The caller is responsible for 'out' holding 
+// at least serialized_size<UnitT>(count) bytes. Returns the number of 
+// bytes written.
+//
+// clang-format off
+template <typename ArithT, typename ScaleT, typename TagT>
+auto serialize(const Unit<ArithT, ScaleT, TagT>* units,
+               const std::size_t count, 
+               unsigned char* out) noexcept -> std::size_t {
+  using UnitT = Unit<ArithT, ScaleT, TagT>;
+  static_assert(sizeof(UnitT) == sizeof(ArithT), "unexpected unit padding");
+
+  const std::uint64_t fingerprint = unit_fingerprint_v<UnitT>;
+  const auto n = static_cast<std::uint64_t>(count);
+  units_internal::CopyLittleEndian(
+      out, reinterpret_cast<const unsigned char*>(&fingerprint), 8);
+  units_internal::CopyLittleEndian(
+      out + 8, reinterpret_cast<const unsigned char*>(&n), 8);
+  out += units_internal::kSerializedHeaderSize;
+
+  if (units_internal::kLittleEndianHost) {
+    // Fast path, units are laid out exactly as their values.
+    if (count > 0) {
+      std::memcpy(out, units, count * sizeof(ArithT));
+    }
+  } else {
+    for (std::size_t i = 0; i < count; ++i) {
+      const ArithT v = units[i].value();
+      units_internal::CopyLittleEndian(
+          out + i * sizeof(ArithT), 
+          reinterpret_cast<const unsigned char*>(&v), sizeof(ArithT));
+    }
+  }
+  return serialized_size<UnitT>(count);
+}
+// clang-format on
+
+// Write a single unit, same format as a span of length one.
+template <typename ArithT, typename ScaleT, typename TagT>
+auto serialize(const Unit<ArithT, ScaleT, TagT>& u, unsigned char* out) noexcept
+    -> std::size_t {
+  return serialize(&u, 1, out);
+}
+
+// Returns the number of units stored in a serialized buffer, or zero
+// if 'size' is too small to hold a header. Does not check the fingerprint.
+NO_DISCARD inline auto serialized_count(const unsigned char* in,
+                                        const std::size_t size) noexcept
+    -> std::size_t {
+  if (size < units_internal::kSerializedHeaderSize) {
+    return 0;
+  }
+  std::uint64_t n = 0;
+  units_internal::CopyLittleEndian(reinterpret_cast<unsigned char*>(&n),
+                                   in + 8, 8);
+  return static_cast<std::size_t>(n);
+}
+
+// Read exactly 'count' units of type UnitT from a buffer written by 
+// serialize. Returns false, leaving 'out' untouched, if the buffer holds 
+// a different unit type (fingerprint mismatch), a different number of 
+// units or is truncated.
+//
+// clang-format off
+template <typename UnitT>
+NO_DISCARD auto deserialize(const unsigned char* in, 
+                            const std::size_t size,
+                            UnitT* out, 
+                            const std::size_t count) noexcept -> bool {
+  using ArithT = typename UnitT::ValueType;
+  static_assert(sizeof(UnitT) == sizeof(ArithT), "unexpected unit padding");
+
+  if (size < units_internal::kSerializedHeaderSize) {
+    return false;
+  }
+  std::uint64_t fingerprint = 0;
+  units_internal::CopyLittleEndian(
+      reinterpret_cast<unsigned char*>(&fingerprint), in, 8);
+  if (fingerprint != unit_fingerprint_v<UnitT>) {
+    return false;
+  }
+  if (serialized_count(in, size) != count || 
+      size < serialized_size<UnitT>(count)) {
+    return false;
+  }
+  in += units_internal::kSerializedHeaderSize;
+
+  if (units_internal::kLittleEndianHost) {
+    if (count > 0) {
+      std::memcpy(out, in, count * sizeof(ArithT));
+    }
+  } else {
+    for (std::size_t i = 0; i < count; ++i) {
+      ArithT v;
+      units_internal::CopyLittleEndian(
+          reinterpret_cast<unsigned char*>(&v), 
+          in + i * sizeof(ArithT), sizeof(ArithT));
+      out[i] = UnitT{std::move(v)};
+    }
+  }
+  return true;
+}
+// clang-format on
+
+// Read a single unit, see above.
+template <typename UnitT>
+NO_DISCARD auto deserialize(const unsigned char* in, const std::size_t size,
+                            UnitT& out) noexcept -> bool {
+  return deserialize(in, size, &out, 1);
+}
+
+// Compact encoding of slowly varying integer units, e.g. telemetry.
+// Each value is stored as the difference to the previous value, mapped 
+// to an unsigned integer using zigzag encoding (small magnitudes give
+// small integers) and written as a LEB128 varint, i.e. seven bits per 
+// byte with the high bit set on all but the last byte. Differences in 
+// [-64, 63] use a single byte. The stream starts with the unit fingerprint
+// as an 8-byte little-endian header.
+//
+// Encoding and decoding are streaming: spans can be passed in chunks and 
+// the previous value is carried over between calls.
+//
+// clang-format off
+template <typename UnitT>
+class DeltaEncoder {
+  using ValueType = typename UnitT::ValueType;
+  static_assert(std::is_integral_v<ValueType>, 
+                "delta encoding requires integer value type");
+  using UnsignedType = std::make_unsigned_t<ValueType>;
+
+ public:
+  static constexpr std::size_t kHeaderSize = 8;
+  static constexpr std::size_t kMaxBytesPerValue = 
+      (8 * sizeof(ValueType) + 6) / 7;
+
+  // Upper bound on the number of bytes written by encode for 'count' units.
+  NO_DISCARD static constexpr auto max_encoded_size(
+      const std::size_t count) noexcept -> std::size_t {
+    return count * kMaxBytesPerValue;
+  }
+
+  // Write the stream header, returns the number of bytes written.
+  auto write_header(unsigned char* out) noexcept -> std::size_t {
+    const std::uint64_t fingerprint = unit_fingerprint_v<UnitT>;
+    units_internal::CopyLittleEndian(
+        out, reinterpret_cast<const unsigned char*>(&fingerprint), 8);
+    return kHeaderSize;
+  }
+
+  // Encode 'count' units, 'out' must hold at least max_encoded_size(count)
+  // bytes. Returns the number of bytes written.
+  auto encode(const UnitT* units, const std::size_t count, 
+              unsigned char* out) noexcept -> std::size_t {
+    constexpr int kBits = 8 * sizeof(ValueType);
+    unsigned char* p = out;
+    // Local copy, stores to 'out' could otherwise alias the member.
+    UnsignedType prev = prev_;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto v = static_cast<UnsignedType>(units[i].value());
+      const auto d = static_cast<UnsignedType>(v - prev);
+      prev = v;
+      auto zz = static_cast<UnsignedType>(
+          static_cast<UnsignedType>(d << 1) ^
+          static_cast<UnsignedType>(-static_cast<UnsignedType>(d >> (kBits - 1))));
+      while (zz >= 0x80) {
+        *p++ = static_cast<unsigned char>(zz | 0x80);
+        zz = static_cast<UnsignedType>(zz >> 7);
+      }
+      *p++ = static_cast<unsigned char>(zz);
+    }
+    prev_ = prev;
+    return static_cast<std::size_t>(p - out);
+  }
+
+ private:
+  UnsignedType prev_ = 0;
+};
+// clang-format on
+
+// Result of DeltaDecoder::decode. 'count' units were written and 'ptr'
+// points to the first byte that was not consumed. 
+struct DeltaDecodeResult {
+  const unsigned char* ptr;
+  std::size_t count;
+  std::errc ec;
+};
+
+// Decoder for streams written by DeltaEncoder, see above.
+//
+// clang-format off
+template <typename UnitT>
+class DeltaDecoder {
+  using ValueType = typename UnitT::ValueType;
+  static_assert(std::is_integral_v<ValueType>, 
+                "delta encoding requires integer value type");
+  using UnsignedType = std::make_unsigned_t<ValueType>;
+
+ public:
+  static constexpr std::size_t kHeaderSize = DeltaEncoder<UnitT>::kHeaderSize;
+
+  // Returns false if the stream was not written for units of type UnitT
+  // or is too short to hold a header.
+  NO_DISCARD auto read_header(const unsigned char* in, 
+                              const std::size_t size) noexcept -> bool {
+    if (size < kHeaderSize) {
+      return false;
+    }
+    std::uint64_t fingerprint = 0;
+    units_internal::CopyLittleEndian(
+        reinterpret_cast<unsigned char*>(&fingerprint), in, 8);
+    return fingerprint == unit_fingerprint_v<UnitT>;
+  }
+
+  // Decode at most 'count' units from [in, in + size). A value that is
+  // cut off at the end of the input is not consumed, so that decoding can 
+  // resume from 'ptr' once more input is available. Varints that are too 
+  // long for the value type, or whose last byte has bits beyond it, give
+  // std::errc::invalid_argument.
+  auto decode(const unsigned char* in, const std::size_t size, 
+              UnitT* out, const std::size_t count) noexcept 
+      -> DeltaDecodeResult {
+    const unsigned char* p = in;
+    const unsigned char* const end = in + size;
+    std::size_t i = 0;
+    // Local copy, stores to 'out' could otherwise alias the member.
+    UnsignedType prev = prev_;
+    while (i < count) {
+      // Fast path, eight consecutive single-byte varints. Checked with one
+      // 64-bit test and decoded without branches.
+      while (count - i >= 8 && end - p >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        if ((word & 0x8080808080808080ULL) != 0) {
+          break;
+        }
+        UnsignedType d[8];
+        for (int k = 0; k < 8; ++k) {
+          d[k] = Unzigzag(static_cast<UnsignedType>(p[k]));
+        }
+        for (int k = 0; k < 8; ++k) {
+          prev = static_cast<UnsignedType>(prev + d[k]);
+          out[i + k] = UnitT{static_cast<ValueType>(prev)};
+        }
+        p += 8;
+        i += 8;
+      }
+      if (i == count || p == end) {
+        break;
+      }
+
+      // General case.
+      UnsignedType zz = 0;
+      const unsigned char* q = p;
+      int shift = 0;
+      for (;;) {
+        if (q == end) {
+          prev_ = prev;
+          return {p, i, std::errc{}};  // Truncated, resume later.
+        }
+        if (shift >= 8 * static_cast<int>(sizeof(ValueType))) {
+          prev_ = prev;
+          return {p, i, std::errc::invalid_argument};
+        }
+        const unsigned char b = *q++;
+        // The last byte that fits may only use the remaining bits.
+        const int remaining_bits = 8 * static_cast<int>(sizeof(ValueType)) -
+                                   shift;
+        if (remaining_bits < 7 && ((b & 0x7f) >> remaining_bits) != 0) {
+          prev_ = prev;
+          return {p, i, std::errc::invalid_argument};
+        }
+        zz = static_cast<UnsignedType>(
+            zz | static_cast<UnsignedType>(
+                     static_cast<UnsignedType>(b & 0x7f) << shift));
+        if ((b & 0x80) == 0) {
+          break;
+        }
+        shift += 7;
+      }
+      p = q;
+      prev = static_cast<UnsignedType>(prev + Unzigzag(zz));
+      out[i++] = UnitT{static_cast<ValueType>(prev)};
+    }
+    prev_ = prev;
+    return {p, i, std::errc{}};
+  }
+
+ private:
+  NO_DISCARD static constexpr auto Unzigzag(const UnsignedType zz) noexcept 
+      -> UnsignedType {
+    return static_cast<UnsignedType>(
+        static_cast<UnsignedType>(zz >> 1) ^
+        static_cast<UnsignedType>(-static_cast<UnsignedType>(zz & 1)));
+  }
+
+  UnsignedType prev_ = 0;
+};
+// clang-format on
+
+namespace units_internal {
+
+// Scale 'v', given in the units described by 'suffix', to ToUnitT if 
+// PairT has that suffix and the same tag as ToUnitT. 
+template <typename PairT, typename ToUnitT>
+NO_DISCARD auto TryScaleFromSuffix(const char* suffix, const std::size_t len,
+                                   const typename ToUnitT::ValueType v,
+                                   ToUnitT& out) noexcept -> bool {
+  using ScaleT = typename PairT::ScaleType;
+  using TagT = typename PairT::TagType;
+  if constexpr (std::is_same_v<TagT, typename ToUnitT::TagType>) {
+    if (SuffixEquals(TagSuffix<ScaleT, TagT>::c_str(), suffix, len)) {
+      using ValueType = typename ToUnitT::ValueType;
+      out = ToUnitT{ScaleHelper<ScaleT, typename ToUnitT::ScaleType>::
+                        template Scale<ValueType>(v)};
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename ToUnitT, typename... Ps>
+NO_DISCARD auto ScaleFromSuffix(TypeList<Ps...>, const char* suffix,
+                                const std::size_t len,
+                                const typename ToUnitT::ValueType v,
+                                ToUnitT& out) noexcept -> bool {
+  return (TryScaleFromSuffix<Ps>(suffix, len, v, out) || ...);
+}
+
+}  // namespace units_internal
+
+// Parse a unit from [first, last) on the form "<number> <suffix>" or 
+// "<number> [<suffix>]", the latter being the format written by the output
+// stream operator. Follows the conventions of std::from_chars: numbers
+// are parsed with C-locale semantics, leading whitespace and '+' signs
+// are not accepted, and on success 'ptr' points one past the suffix 
+// (or closing bracket).
+//
+// Any suffix with the same tag as UnitT is accepted and the parsed value
+// is converted to the scale of UnitT, e.g. "12 [cGy]" can be read into
+// Gray<float>. Unknown suffixes, or suffixes with another tag, give 
+// std::errc::invalid_argument and leave 'value' untouched.
+//
+// clang-format off
+template <typename ArithT, typename ScaleT, typename TagT>
+auto from_chars(const char* first, const char* last, 
+                Unit<ArithT, ScaleT, TagT>& value) noexcept 
+    -> std::from_chars_result {
+  ArithT v{};
+  auto r = std::from_chars(first, last, v);
+  if (r.ec != std::errc{}) {
+    return r;
+  }
+
+  const char* p = r.ptr;
+  while (p != last && units_internal::IsSpace(*p)) { ++p; }
+  const bool bracket = p != last && *p == '[';
+  p += bracket ? 1 : 0;
+  const char* suffix = p;
+  while (p != last && !units_internal::IsSpace(*p) && *p != ']' && 
+         *p != '\n') { 
+    ++p; 
+  }
+  const auto len = static_cast<std::size_t>(p - suffix);
+  if (bracket) {
+    if (p == last || *p != ']') {
+      return {first, std::errc::invalid_argument};
+    }
+    ++p;
+  }
+
+  auto u = value;
+  using PairsT = typename units_internal::PairsForTag<
+      TagT, units_internal::TagScales<TagT>>::type;
+  if (!units_internal::ScaleFromSuffix(PairsT{},
+                                       suffix, len, v, u)) {
+    return {first, std::errc::invalid_argument};
+  }
+  value = u;
+  return {p, std::errc{}};
+}
+// clang-format on
+
+// Write a unit to [first, last) as "<value> [<suffix>]", the same format 
+// as the output stream operator. Follows the conventions of std::to_chars:
+// values are formatted with C-locale semantics (floating point values use
+// the shortest representation that round-trips through from_chars), no
+// locale facets are consulted and nothing is allocated. On success 'ptr' 
+// points one past the last character written, if the range is too small
+// 'ec' is std::errc::value_too_large.
+//
+// This is the preferred way of formatting units where throughput or 
+// independence of the global locale matters, e.g. when writing from 
+// several threads.
+//
+// clang-format off
+template <typename ArithT, typename ScaleT, typename TagT>
+auto to_chars(char* first, char* last, 
+              const Unit<ArithT, ScaleT, TagT> u) noexcept 
+    -> std::to_chars_result {
+  auto r = std::to_chars(first, last, u.value());
+  if (r.ec != std::errc{}) {
+    return r;
+  }
+  const char* suffix = units_internal::TagSuffix<ScaleT, TagT>::c_str();
+  const auto len = std::strlen(suffix);
+  if (static_cast<std::size_t>(last - r.ptr) < len + 3) {
+    return {last, std::errc::value_too_large};
+  }
+  char* p = r.ptr;
+  *p++ = ' ';
+  *p++ = '[';
+  std::memcpy(p, suffix, len);
+  p += len;
+  *p++ = ']';
+  return {p, std::errc{}};
+}
+// clang-format on
+
+// Convenience wrapper around to_chars.
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto to_string(const Unit<ArithT, ScaleT, TagT> u) -> std::string {
+  // Room for the value of any built-in arithmetic type and the suffix,
+  // which may be arbitrarily long for user-defined scales. Grown if
+  // to_chars still runs out of space.
+  std::string s(
+      64 + std::strlen(units_internal::TagSuffix<ScaleT, TagT>::c_str()), '\0');
+  for (;;) {
+    const auto r = to_chars(s.data(), s.data() + s.size(), u);
+    if (r.ec == std::errc{}) {
+      s.resize(static_cast<std::size_t>(r.ptr - s.data()));
+      return s;
+    }
+    s.resize(2 * s.size());
+  }
+}
+
+// Result of parse_lines. 'count' is the number of complete records 
+// written to the columns. If 'ec' is set, 'ptr' points to the start of
+// the line that failed to parse. Otherwise 'ptr' points to the first 
+// line that was not read, which is 'last' unless the columns are full.
+struct ParseLinesResult {
+  std::size_t count;
+  const char* ptr;
+  std::errc ec;
+};
+
+// Parse newline-separated records from [first, last) into typed columns,
+// one unit per column on each line separated by whitespace, e.g. 
+//
+//   Degrees<float> gantry[n];
+//   Gray<float> dose[n];
+//   parse_lines(first, last, n, gantry, dose);
+//
+// reads lines like "123.45 [deg] 0.02 [Gy]". Blank lines are skipped.
+// Each field is parsed with from_chars above, so suffixes are validated
+// against the unit tag of each column and values are converted to the 
+// column scale.
+//
+// Line ends are located with std::memchr, which standard libraries 
+// implement using wide (SIMD) loads, and numbers with std::from_chars.
+// No allocations are made and the locale is never consulted.
+//
+// clang-format off
+template <typename... UnitTs>
+auto parse_lines(const char* first, const char* last, 
+                 const std::size_t capacity, 
+                 UnitTs*... columns) noexcept -> ParseLinesResult {
+  static_assert(sizeof...(UnitTs) > 0, "at least one column required");
+  std::size_t count = 0;
+  while (first != last && count < capacity) {
+    const auto* eol = static_cast<const char*>(
+        std::memchr(first, '\n', static_cast<std::size_t>(last - first)));
+    const char* line_end = eol != nullptr ? eol : last;
+    const char* next = eol != nullptr ? eol + 1 : last;
+
+    const char* p = first;
+    while (p != line_end && units_internal::IsSpace(*p)) { ++p; }
+    if (p == line_end) {
+      first = next;  // Blank line.
+      continue;
+    }
+
+    bool ok = true;
+    const auto parse_field = [&](auto* column) {
+      if (!ok) {
+        return;
+      }
+      while (p != line_end && units_internal::IsSpace(*p)) { ++p; }
+      const auto r = from_chars(p, line_end, column[count]);
+      ok = r.ec == std::errc{};
+      p = r.ptr;
+    };
+    (parse_field(columns), ...);
+    while (ok && p != line_end && units_internal::IsSpace(*p)) { ++p; }
+    if (!ok || p != line_end) {
+      return {count, first, std::errc::invalid_argument};
+    }
+
+    ++count;
+    first = next;
+  }
+  return {count, first, std::errc{}};
+}
+// clang-format on
+
+// Explicit instantiation of the text output functions for a unit type. 
+// Prefix is either empty (definition) or extern (declaration). 
+//
+// NOTE(thinks):
+//   from_chars is not included, it depends on the scales registered for
+//   the tag (THINKS_UNITS_TAG_SCALES), which may differ between 
+//   translation units.
+#define THINKS_UNITS_IO_INSTANTIATE(Prefix, UnitT)                      \
+  Prefix template auto to_chars(char*, char*, const UnitT) noexcept   \
+      -> std::to_chars_result;                                        \
+  Prefix template auto to_string(const UnitT) -> std::string;         \
+  Prefix template std::ostream& operator<<(std::ostream&, const UnitT&);
+
+// Commonly used units. The thinks_units_inst library instantiates these 
+// once and defines THINKS_UNITS_EXTERN_TEMPLATES for its users, such that 
+// other translation units do not instantiate (and compile) them again.
+#define THINKS_UNITS_IO_INSTANTIATE_COMMON(Prefix)                      \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Meters<double>)                  \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Centimeters<double>)             \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Millimeters<double>)             \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Millimeters<float>)              \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Degrees<double>)                 \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Degrees<float>)                  \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Radians<double>)                 \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Gray<double>)                    \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Gray<float>)                     \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, CentiGray<float>)                \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Seconds<double>)                 \
+  THINKS_UNITS_IO_INSTANTIATE(Prefix, Milliseconds<double>)
+
+#if defined(THINKS_UNITS_EXTERN_TEMPLATES)
+THINKS_UNITS_IO_INSTANTIATE_COMMON(extern)
+#endif
+
+#undef NO_DISCARD
+
+}  // namespace thinks
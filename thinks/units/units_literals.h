@@ -0,0 +1,332 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// User-defined literals for the built-in units, and compile-time parsing
+// of unit strings (C++20).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+inline namespace unit_literals {
+
+// Literals.
+//
+// NOTE(thinks): 
+//   Would be nice if there was a way to specify the value type of 
+//   the constructed units. Currently (C++14), there is no way to 
+//   pass a type argument to a literal operator since templating
+//   is limited for literals. Hence, we fall back on hard-coding
+//   the value types for the constructed unit objects.
+NO_DISCARD constexpr auto operator"" _m(unsigned long long v)
+    // noexcept
+    -> Meters<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _m(long double v)
+    // noexcept
+    -> Meters<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _cm(unsigned long long v)
+    // noexcept
+    -> Centimeters<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _cm(long double v)
+    // noexcept
+    -> Centimeters<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _mm(unsigned long long v)
+    // noexcept
+    -> Millimeters<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _mm(long double v)
+    // noexcept
+    -> Millimeters<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _deg(unsigned long long v)
+    // noexcept
+    -> Degrees<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _deg(long double v)
+    // noexcept 
+    -> Degrees<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _rad(unsigned long long v)
+    // noexcept 
+    -> Radians<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _rad(long double v)
+    // noexcept 
+    -> Radians<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _Gy(unsigned long long v)
+    // noexcept 
+    -> Gray<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _Gy(long double v)
+    // noexcept 
+    -> Gray<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _cGy(unsigned long long v)
+    // noexcept 
+    -> CentiGray<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _cGy(long double v)
+    // noexcept 
+    -> CentiGray<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _s(unsigned long long v)
+    // noexcept 
+    -> Seconds<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _s(long double v)
+    // noexcept 
+    -> Seconds<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+NO_DISCARD constexpr auto operator"" _ms(unsigned long long v)
+    // noexcept 
+    -> Milliseconds<units_internal::LiteralIntType> {
+  return {units_internal::numeric_cast<units_internal::LiteralIntType>(v)};
+}
+NO_DISCARD constexpr auto operator"" _ms(long double v)
+    // noexcept 
+    -> Milliseconds<units_internal::LiteralFloatType> {
+  return {units_internal::numeric_cast<units_internal::LiteralFloatType>(v)};
+}
+
+} // namespace literals
+
+#if (__cplusplus >= 202002L) && defined(__cpp_nontype_template_args) && \
+    (__cpp_nontype_template_args >= 201911L)
+namespace units_internal {
+
+// String wrapper that can be used as a template argument.
+template <std::size_t N>
+struct FixedString {
+  char data[N] = {};
+
+  constexpr FixedString(const char (&s)[N]) noexcept {
+    for (std::size_t i = 0; i < N; ++i) {
+      data[i] = s[i];
+    }
+  }
+
+  NO_DISCARD constexpr std::size_t size() const noexcept { return N - 1; }
+};
+
+// Not constexpr, calling this during constant evaluation is what makes 
+// parsing errors show up as compilation errors.
+inline void UnitParseError(const char* /*msg*/) {}
+
+struct ParsedUnitString {
+  bool is_float = false;
+  LiteralIntType int_value = 0;
+  LiteralFloatType float_value = 0;
+  std::size_t suffix_index = 0;
+};
+
+// Parses strings on the form "<number> <suffix>" or "<number> [<suffix>]",
+// where the latter is the format produced by the output stream operator.
+// The number is treated as a floating point value if it contains a decimal
+// point or an exponent, otherwise as an integer, same as for literals.
+//
+// Floating point values are correctly rounded when the decimal mantissa 
+// has at most 19 digits and can be exactly represented along with the 
+// power of ten (the common case for hand-written constants), otherwise 
+// the result may be off by one ulp.
+template <typename ListT>
+NO_DISCARD constexpr auto ParseUnitString(const char* s, const std::size_t n)
+    -> ParsedUnitString {
+  ParsedUnitString r;
+  std::size_t i = 0;
+  while (i < n && IsSpace(s[i])) { ++i; }
+
+  bool negative = false;
+  if (i < n && (s[i] == '-' || s[i] == '+')) {
+    negative = s[i] == '-';
+    ++i;
+  }
+
+  // Decimal mantissa and exponent.
+  std::uint64_t mantissa = 0;
+  int mantissa_digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  for (; i < n && IsDigit(s[i]); ++i) {
+    any_digits = true;
+    if (mantissa_digits < 19) {
+      mantissa = 10 * mantissa + static_cast<std::uint64_t>(s[i] - '0');
+      mantissa_digits += mantissa != 0 ? 1 : 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (i < n && s[i] == '.') {
+    r.is_float = true;
+    for (++i; i < n && IsDigit(s[i]); ++i) {
+      any_digits = true;
+      if (mantissa_digits < 19) {
+        mantissa = 10 * mantissa + static_cast<std::uint64_t>(s[i] - '0');
+        mantissa_digits += mantissa != 0 ? 1 : 0;
+        --exponent;
+      }
+    }
+  }
+  if (!any_digits) {
+    UnitParseError("expected number");
+  }
+  if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+    r.is_float = true;
+    ++i;
+    bool negative_exponent = false;
+    if (i < n && (s[i] == '-' || s[i] == '+')) {
+      negative_exponent = s[i] == '-';
+      ++i;
+    }
+    if (!(i < n && IsDigit(s[i]))) {
+      UnitParseError("expected exponent");
+    }
+    int e = 0;
+    for (; i < n && IsDigit(s[i]); ++i) {
+      e = e < 10000 ? 10 * e + (s[i] - '0') : e;
+    }
+    exponent += negative_exponent ? -e : e;
+  }
+
+  if (r.is_float) {
+    // Powers of ten up to 1e22 are exact in double precision.
+    constexpr double kExactPow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    long double v = 0;
+    if (mantissa <= (std::uint64_t{1} << 53) && -22 <= exponent &&
+        exponent <= 22) {
+      const double m = static_cast<double>(mantissa);
+      v = exponent < 0 ? m / kExactPow10[-exponent] 
+                       : m * kExactPow10[exponent];
+    } else {
+      v = static_cast<long double>(mantissa);
+      for (; exponent > 0; --exponent) { v *= 10; }
+      for (; exponent < 0; ++exponent) { v /= 10; }
+    }
+    r.float_value = static_cast<LiteralFloatType>(negative ? -v : v);
+  } else {
+    if (exponent != 0 || 
+        mantissa > static_cast<std::uint64_t>(
+                       std::numeric_limits<LiteralIntType>::max())) {
+      UnitParseError("integer out of range");
+    }
+    const auto v = static_cast<LiteralIntType>(mantissa);
+    r.int_value = negative ? -v : v;
+  }
+
+  // Suffix, optionally enclosed in brackets.
+  while (i < n && IsSpace(s[i])) { ++i; }
+  const bool bracket = i < n && s[i] == '[';
+  i += bracket ? 1 : 0;
+  const std::size_t first = i;
+  while (i < n && !IsSpace(s[i]) && s[i] != ']') { ++i; }
+  r.suffix_index = FindSuffix(ListT{}, s + first, i - first);
+  if (bracket) {
+    if (!(i < n && s[i] == ']')) {
+      UnitParseError("expected ']'");
+    }
+    ++i;
+  }
+  while (i < n && IsSpace(s[i])) { ++i; }
+  if (i != n) {
+    UnitParseError("unexpected trailing characters");
+  }
+  return r;
+}
+
+}  // namespace units_internal
+
+// Parse a string on the form "12.3 mm" (or "12.3 [mm]") at compile-time.
+// The unit type is selected from the suffix, the value type follows the
+// same rules as for literals, i.e. 
+//
+//   thinks::parse<"12.3 cGy">() == 12.3_cGy
+//   thinks::parse<"12 cGy">() == 12_cGy
+//
+// Invalid strings and unknown suffixes do not compile.
+template <units_internal::FixedString S>
+NO_DISCARD consteval auto parse() {
+  using ListT = units_internal::SuffixedUnits<decltype(S)>;
+  constexpr auto r = units_internal::ParseUnitString<ListT>(S.data, S.size());
+  static_assert(r.suffix_index < units_internal::TypeListSize<ListT>::value,
+                "unknown unit suffix");
+  using PairT = units_internal::TypeAtT<r.suffix_index, ListT>;
+  if constexpr (r.is_float) {
+    return Unit<units_internal::LiteralFloatType, typename PairT::ScaleType,
+                typename PairT::TagType>{
+        units_internal::LiteralFloatType{r.float_value}};
+  } else {
+    return Unit<units_internal::LiteralIntType, typename PairT::ScaleType,
+                typename PairT::TagType>{
+        units_internal::LiteralIntType{r.int_value}};
+  }
+}
+
+inline namespace unit_literals {
+
+// String literal version of parse, e.g. "12.3 mm"_unit.
+template <units_internal::FixedString S>
+NO_DISCARD consteval auto operator""_unit() {
+  return parse<S>();
+}
+
+}  // namespace unit_literals
+#endif
+
+#undef NO_DISCARD
+
+}  // namespace thinks
+
+// Integer and floating point literals for a unit alias template, with
+// the same value types as the built-in literals.
+#define THINKS_UNITS_LITERAL(UnitTemplate, literal)                          \
+  constexpr auto operator"" literal(unsigned long long v)                   \
+      -> UnitTemplate<thinks::units_internal::LiteralIntType> {             \
+    return {static_cast<thinks::units_internal::LiteralIntType>(v)};        \
+  }                                                                         \
+  constexpr auto operator"" literal(long double v)                          \
+      -> UnitTemplate<thinks::units_internal::LiteralFloatType> {           \
+    return {static_cast<thinks::units_internal::LiteralFloatType>(v)};      \
+  }
@@ -0,0 +1,64 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Consumer of the thinks.units module. The same source is also built with
+// the header (THINKS_UNITS_USE_HEADER), such that build times of the two
+// targets can be compared directly.
+//
+// NOTE(thinks):
+//   No standard headers are included here, mixing textual inclusion of
+//   standard headers with the module's global module fragment triggers
+//   compiler bugs in some implementations (e.g. GCC 12).
+
+#if defined(THINKS_UNITS_USE_HEADER)
+#include "thinks/units/units.h"
+#else
+import thinks.units;
+#endif
+
+namespace {
+
+constexpr bool StaticTests() {
+  using namespace thinks::unit_literals;
+
+  static_assert(thinks::unit_cast<thinks::Millimeters<double>>(1_cm) ==
+                    10.0_mm,
+                "");
+  static_assert(1_cm == 10.0_mm && 41_mm > 4_cm, "");
+  static_assert(2_cm + 3_cm == 5_cm && 14_cm / 70_mm == 2, "");
+  static_assert(2_mm * 3_mm == thinks::SquareMillimeters<int>{6}, "");
+  static_assert(thinks::clamp(5_cm, 1_mm, 2_cm) == 20_mm, "");
+  static_assert(1_rad > 57_deg && 1_rad < 58_deg, "");
+  return true;
+}
+
+bool RuntimeTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+  // Only members of standard types are reachable through the module.
+  success &=
+      thinks::to_string(thinks::Gray<float>{0.5F}).compare("0.5 [Gy]") == 0;
+
+  const auto str = thinks::to_string(12.5_cm);
+  auto x = thinks::Millimeters<double>{0.0};
+  const auto r = thinks::from_chars(str.data(), str.data() + str.size(), x);
+  success &= r.ec == decltype(r.ec){} && x == 125_mm;
+
+  // NOTE(thinks):
+  //   The parallel algorithms are not called here since some compilers
+  //   fail to instantiate std::function from the module (e.g. GCC 12),
+  //   they are covered by units_test.cc.
+  thinks::ThreadPool pool(2);
+  auto policy = thinks::execution::par;
+  policy.executor = pool;
+  success &= static_cast<bool>(policy.executor) && pool.concurrency() == 3U;
+  return success;
+}
+
+}  // namespace
+
+int main() {
+  static_assert(StaticTests(), "");
+  return RuntimeTests() ? 0 : 1;
+}
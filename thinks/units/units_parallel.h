@@ -0,0 +1,446 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Parallel algorithms on ranges of units.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thinks/units/units_core.h"
+#include "thinks/units/units_thread_pool.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+// Execution policies for the range algorithms, similar to those in
+// std::execution. These are used rather than the standard policies
+// since the parallel standard algorithms are not available with all
+// standard library implementations, and do not allow control over the
+// number of threads.
+namespace execution {
+
+struct SequencedPolicy {};
+
+struct ParallelPolicy {
+  // Maximum number of threads, zero means the concurrency of the
+  // executor.
+  unsigned thread_count = 0;
+
+  // Minimum number of elements processed by a task.
+  std::size_t grain_size = std::size_t{1} << 14;
+
+  // Executor that runs the tasks, empty means ThreadPool::default_pool().
+  ExecutorRef executor;
+};
+
+inline constexpr SequencedPolicy seq{};
+inline constexpr ParallelPolicy par{};
+
+}  // namespace execution
+
+namespace units_internal {
+
+// Number of independent accumulators in the inner loops, such that
+// the compiler can vectorize them without reassociating floating point
+// operations.
+inline constexpr std::size_t kLaneCount = 8;
+
+// Sum of unit values, accumulated in ResultT.
+template <typename ResultT, typename UnitT>
+NO_DISCARD auto SumKernel(const UnitT* values, const std::size_t count)
+    noexcept -> ResultT {
+  ResultT acc[kLaneCount] = {};
+  std::size_t i = 0;
+  for (; i + kLaneCount <= count; i += kLaneCount) {
+    for (std::size_t j = 0; j < kLaneCount; ++j) {
+      acc[j] += static_cast<ResultT>(values[i + j].value());
+    }
+  }
+  for (; i < count; ++i) {
+    acc[i % kLaneCount] += static_cast<ResultT>(values[i].value());
+  }
+  for (std::size_t n = kLaneCount / 2; n > 0; n /= 2) {
+    for (std::size_t j = 0; j < n; ++j) {
+      acc[j] += acc[j + n];
+    }
+  }
+  return acc[0];
+}
+
+// Smallest and largest unit values, count must be non-zero.
+template <typename UnitT>
+NO_DISCARD auto MinMaxKernel(const UnitT* values, const std::size_t count)
+    noexcept -> std::pair<UnitT, UnitT> {
+  using ArithT = typename UnitT::ValueType;
+  ArithT lo[kLaneCount];
+  ArithT hi[kLaneCount];
+  for (std::size_t j = 0; j < kLaneCount; ++j) {
+    lo[j] = values[0].value();
+    hi[j] = values[0].value();
+  }
+  std::size_t i = 0;
+  for (; i + kLaneCount <= count; i += kLaneCount) {
+    for (std::size_t j = 0; j < kLaneCount; ++j) {
+      const ArithT v = values[i + j].value();
+      lo[j] = v < lo[j] ? v : lo[j];
+      hi[j] = hi[j] < v ? v : hi[j];
+    }
+  }
+  for (; i < count; ++i) {
+    const ArithT v = values[i].value();
+    lo[0] = v < lo[0] ? v : lo[0];
+    hi[0] = hi[0] < v ? v : hi[0];
+  }
+  for (std::size_t j = 1; j < kLaneCount; ++j) {
+    lo[0] = lo[j] < lo[0] ? lo[j] : lo[0];
+    hi[0] = hi[0] < hi[j] ? hi[j] : hi[0];
+  }
+  return {UnitT{ArithT{lo[0]}}, UnitT{ArithT{hi[0]}}};
+}
+
+NO_DISCARD inline auto GetExecutor(const execution::ParallelPolicy& policy)
+    -> ExecutorRef {
+  return policy.executor ? policy.executor
+                         : ExecutorRef{ThreadPool::default_pool()};
+}
+
+// Number of tasks to use for a range, limited by the grain size. Unless
+// the policy limits the number of threads there are a few tasks per
+// thread, such that work can be balanced by stealing.
+inline constexpr std::size_t kTasksPerThread = 4;
+NO_DISCARD inline auto ChunkCount(const execution::ParallelPolicy& policy,
+                                  const std::size_t count) -> std::size_t {
+  const auto max_count =
+      policy.thread_count != 0
+          ? std::size_t{policy.thread_count}
+          : kTasksPerThread * GetExecutor(policy).concurrency();
+  const auto grain_size = std::max(policy.grain_size, std::size_t{1});
+  return std::max(std::size_t{1}, std::min(max_count, count / grain_size));
+}
+
+// Call f(k, begin, end) for chunk_count contiguous non-empty chunks k
+// of [0, count), as tasks of the executor.
+template <typename F>
+void ParallelChunks(const execution::ParallelPolicy& policy,
+                    const std::size_t chunk_count, const std::size_t count,
+                    F&& f) {
+  const auto chunk_begin = [count, chunk_count](const std::size_t k) {
+    return k * (count / chunk_count) + std::min(k, count % chunk_count);
+  };
+  GetExecutor(policy).run(chunk_count, [&](const std::size_t k) {
+    f(k, chunk_begin(k), chunk_begin(k + 1));
+  });
+}
+
+// Call f(k, begin, end) for contiguous non-empty chunks k of
+// [0, item_count), where each item represents a number of elements
+// (e.g. blocks of values). The number of chunks is decided by the total
+// number of elements.
+template <typename F>
+void ChunkedFor(const execution::SequencedPolicy&,
+                const std::size_t item_count, const std::size_t,
+                F&& f) {
+  if (item_count > 0) {
+    f(std::size_t{0}, std::size_t{0}, item_count);
+  }
+}
+template <typename F>
+void ChunkedFor(const execution::ParallelPolicy& policy,
+                const std::size_t item_count,
+                const std::size_t element_count, F&& f) {
+  const auto chunk_count =
+      std::min(ChunkCount(policy, element_count), item_count);
+  if (chunk_count > 1) {
+    ParallelChunks(policy, chunk_count, item_count, f);
+  } else if (item_count > 0) {
+    f(std::size_t{0}, std::size_t{0}, item_count);
+  }
+}
+
+// Apply chunk_f(begin, end) -> T to contiguous non-empty chunks of
+// [0, count) and combine the partial results in order, count must be
+// non-zero.
+template <typename T, typename ChunkF, typename CombineF>
+NO_DISCARD auto ChunkedReduce(const execution::SequencedPolicy&,
+                              const std::size_t count, ChunkF&& chunk_f,
+                              CombineF&&) -> T {
+  return chunk_f(std::size_t{0}, count);
+}
+template <typename T, typename ChunkF, typename CombineF>
+NO_DISCARD auto ChunkedReduce(const execution::ParallelPolicy& policy,
+                              const std::size_t count, ChunkF&& chunk_f,
+                              CombineF&& combine) -> T {
+  const auto chunk_count = ChunkCount(policy, count);
+  if (chunk_count == 1) {
+    return chunk_f(std::size_t{0}, count);
+  }
+
+  std::vector<std::optional<T>> partials(chunk_count);
+  ParallelChunks(policy, chunk_count, count,
+                 [&](const std::size_t k, const std::size_t begin,
+                     const std::size_t end) {
+                   partials[k] = chunk_f(begin, end);
+                 });
+
+  T result = std::move(*partials[0]);
+  for (std::size_t k = 1; k < chunk_count; ++k) {
+    result = combine(std::move(result), std::move(*partials[k]));
+  }
+  return result;
+}
+
+// Number of values per block in reproducible sums. Block boundaries do
+// not depend on the number of threads.
+inline constexpr std::size_t kReproducibleBlockSize = 4096;
+
+// Sum of fixed-size blocks, the block sums are combined in a fixed
+// pairwise order. Threads are assigned contiguous ranges of blocks.
+template <typename ResultT, typename UnitT, typename PolicyT>
+NO_DISCARD auto ReproducibleSum(const PolicyT& policy, const UnitT* values,
+                                const std::size_t count) -> ResultT {
+  const auto block_count =
+      (count + kReproducibleBlockSize - 1) / kReproducibleBlockSize;
+  std::vector<ResultT> partials(block_count);
+  const auto sum_blocks = [&](const std::size_t, const std::size_t begin,
+                              const std::size_t end) {
+    for (std::size_t b = begin; b < end; ++b) {
+      const auto first = b * kReproducibleBlockSize;
+      partials[b] = SumKernel<ResultT>(
+          values + first, std::min(kReproducibleBlockSize, count - first));
+    }
+  };
+  ChunkedFor(policy, block_count, count, sum_blocks);
+
+  for (std::size_t w = 1; w < block_count; w *= 2) {
+    for (std::size_t b = 0; b + w < block_count; b += 2 * w) {
+      partials[b] += partials[b + w];
+    }
+  }
+  return partials[0];
+}
+
+template <typename T>
+struct is_execution_policy : public std::false_type {};
+template <>
+struct is_execution_policy<execution::SequencedPolicy>
+    : public std::true_type {};
+template <>
+struct is_execution_policy<execution::ParallelPolicy>
+    : public std::true_type {};
+template <typename T>
+inline constexpr bool is_execution_policy_v =
+    is_execution_policy<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
+// Value type of the sum of units, follows the promotion rules of
+// operator+.
+template <typename ArithT, typename ScaleT, typename TagT>
+using SumType = decltype(std::declval<Unit<ArithT, ScaleT, TagT>>() +
+                         std::declval<Unit<ArithT, ScaleT, TagT>>());
+
+// Mean values are floating point, integer values are averaged in
+// double precision.
+template <typename ArithT>
+using MeanValueType = std::conditional_t<std::is_floating_point_v<ArithT>,
+                                         ArithT, double>;
+
+}  // namespace units_internal
+
+// Generalized sum of init and the values, where op must be associative
+// and commutative (cf. std::reduce). Each chunk of values is reduced
+// starting from its first value converted to InitUnitT, such that op
+// is called with (InitUnitT, UnitT) and (InitUnitT, InitUnitT).
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT,
+          typename InitArithT, typename InitScaleT, typename BinaryOpT>
+auto reduce(PolicyT&& policy, const Unit<ArithT, ScaleT, TagT>* values,
+            const std::size_t count,
+            const Unit<InitArithT, InitScaleT, TagT> init, BinaryOpT op)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        Unit<InitArithT, InitScaleT, TagT>> {
+  using InitUnitT = Unit<InitArithT, InitScaleT, TagT>;
+  if (count == 0) {
+    return init;
+  }
+  const auto partial = units_internal::ChunkedReduce<InitUnitT>(
+      policy, count,
+      [values, &op](const std::size_t begin, const std::size_t end) {
+        auto acc = unit_cast<InitUnitT>(values[begin]);
+        for (std::size_t i = begin + 1; i < end; ++i) {
+          acc = op(acc, values[i]);
+        }
+        return acc;
+      },
+      op);
+  return op(init, partial);
+}
+template <typename ArithT, typename ScaleT, typename TagT,
+          typename InitArithT, typename InitScaleT, typename BinaryOpT>
+auto reduce(const Unit<ArithT, ScaleT, TagT>* values, const std::size_t count,
+            const Unit<InitArithT, InitScaleT, TagT> init, BinaryOpT op)
+    -> Unit<InitArithT, InitScaleT, TagT> {
+  return reduce(execution::seq, values, count, init, std::move(op));
+}
+
+// Convert an array of units, see unit_cast in units_core.h.
+template <typename PolicyT, typename FromArithT, typename FromScaleT,
+          typename ToArithT, typename ToScaleT, typename TagT>
+auto unit_cast(PolicyT&& policy,
+               const Unit<FromArithT, FromScaleT, TagT>* from,
+               const std::size_t count, Unit<ToArithT, ToScaleT, TagT>* to)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>> {
+  units_internal::ChunkedFor(
+      policy, count, count,
+      [from, to](const std::size_t, const std::size_t begin,
+                 const std::size_t end) {
+        unit_cast(from + begin, end - begin, to + begin);
+      });
+}
+
+// Sum of the values, the value type follows the promotion rules of
+// operator+. Returns zero if count is zero.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto sum(PolicyT&& policy, const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        units_internal::SumType<ArithT, ScaleT, TagT>> {
+  using SumUnitT = units_internal::SumType<ArithT, ScaleT, TagT>;
+  using SumArithT = typename SumUnitT::ValueType;
+  if (count == 0) {
+    return SumUnitT{SumArithT{0}};
+  }
+  return SumUnitT{units_internal::ChunkedReduce<SumArithT>(
+      policy, count,
+      [values](const std::size_t begin, const std::size_t end) {
+        return units_internal::SumKernel<SumArithT>(values + begin,
+                                                    end - begin);
+      },
+      std::plus<SumArithT>{})};
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto sum(const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count)
+    -> units_internal::SumType<ArithT, ScaleT, TagT> {
+  return sum(execution::seq, values, count);
+}
+
+// Sum of the values that is bitwise identical regardless of the
+// execution policy and number of threads, as opposed to sum. Values
+// are summed in fixed-size blocks that are combined in a fixed order.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto reproducible_sum(PolicyT&& policy,
+                                 const Unit<ArithT, ScaleT, TagT>* values,
+                                 const std::size_t count)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        units_internal::SumType<ArithT, ScaleT, TagT>> {
+  using SumUnitT = units_internal::SumType<ArithT, ScaleT, TagT>;
+  using SumArithT = typename SumUnitT::ValueType;
+  if (count == 0) {
+    return SumUnitT{SumArithT{0}};
+  }
+  return SumUnitT{units_internal::ReproducibleSum<SumArithT>(
+      policy, values, count)};
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto reproducible_sum(const Unit<ArithT, ScaleT, TagT>* values,
+                                 const std::size_t count)
+    -> units_internal::SumType<ArithT, ScaleT, TagT> {
+  return reproducible_sum(execution::seq, values, count);
+}
+
+// Arithmetic mean of the values, integer values are averaged in double
+// precision. Count must be non-zero.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto mean(PolicyT&& policy, const Unit<ArithT, ScaleT, TagT>* values,
+                     const std::size_t count)
+    -> std::enable_if_t<
+           units_internal::is_execution_policy_v<PolicyT>,
+           Unit<units_internal::MeanValueType<ArithT>, ScaleT, TagT>> {
+  using MeanArithT = units_internal::MeanValueType<ArithT>;
+  const auto total = units_internal::ChunkedReduce<MeanArithT>(
+      policy, count,
+      [values](const std::size_t begin, const std::size_t end) {
+        return units_internal::SumKernel<MeanArithT>(values + begin,
+                                                     end - begin);
+      },
+      std::plus<MeanArithT>{});
+  return Unit<MeanArithT, ScaleT, TagT>{
+      static_cast<MeanArithT>(total / static_cast<MeanArithT>(count))};
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto mean(const Unit<ArithT, ScaleT, TagT>* values,
+                     const std::size_t count)
+    -> Unit<units_internal::MeanValueType<ArithT>, ScaleT, TagT> {
+  return mean(execution::seq, values, count);
+}
+
+// Smallest and largest of the values, count must be non-zero.
+// NaN values are not handled.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto minmax(PolicyT&& policy,
+                       const Unit<ArithT, ScaleT, TagT>* values,
+                       const std::size_t count)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        std::pair<Unit<ArithT, ScaleT, TagT>,
+                                  Unit<ArithT, ScaleT, TagT>>> {
+  using UnitT = Unit<ArithT, ScaleT, TagT>;
+  using PairT = std::pair<UnitT, UnitT>;
+  return units_internal::ChunkedReduce<PairT>(
+      policy, count,
+      [values](const std::size_t begin, const std::size_t end) {
+        return units_internal::MinMaxKernel(values + begin, end - begin);
+      },
+      [](const PairT& a, const PairT& b) {
+        return PairT{b.first < a.first ? b.first : a.first,
+                     a.second < b.second ? b.second : a.second};
+      });
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto minmax(const Unit<ArithT, ScaleT, TagT>* values,
+                       const std::size_t count)
+    -> std::pair<Unit<ArithT, ScaleT, TagT>, Unit<ArithT, ScaleT, TagT>> {
+  return minmax(execution::seq, values, count);
+}
+
+// Smallest of the values, count must be non-zero.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto min(PolicyT&& policy, const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        Unit<ArithT, ScaleT, TagT>> {
+  return minmax(policy, values, count).first;
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto min(const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count) -> Unit<ArithT, ScaleT, TagT> {
+  return minmax(execution::seq, values, count).first;
+}
+
+// Largest of the values, count must be non-zero.
+template <typename PolicyT, typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto max(PolicyT&& policy, const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count)
+    -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>,
+                        Unit<ArithT, ScaleT, TagT>> {
+  return minmax(policy, values, count).second;
+}
+template <typename ArithT, typename ScaleT, typename TagT>
+NO_DISCARD auto max(const Unit<ArithT, ScaleT, TagT>* values,
+                    const std::size_t count) -> Unit<ArithT, ScaleT, TagT> {
+  return minmax(execution::seq, values, count).second;
+}
+
+#undef NO_DISCARD
+
+}  // namespace thinks
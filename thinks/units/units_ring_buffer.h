@@ -0,0 +1,209 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Bounded lock-free queues of units, e.g. for passing telemetry samples
+// between threads.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+namespace units_internal {
+
+// Assumed size of a cache line. Indices written by different threads
+// are kept on separate cache lines to avoid false sharing.
+inline constexpr std::size_t kCacheLineSize = 64;
+
+NO_DISCARD constexpr auto RoundUpToPowerOfTwo(const std::size_t n) noexcept
+    -> std::size_t {
+  std::size_t p = 1;
+  while (p < n) {
+    p *= 2;
+  }
+  return p;
+}
+
+}  // namespace units_internal
+
+// Bounded queue for a single producer thread and a single consumer
+// thread. All operations are wait-free. The capacity is rounded up to
+// a power of two.
+template <typename UnitT>
+class SpscRingBuffer {
+ public:
+  using UnitType = UnitT;
+  using ValueType = typename UnitT::ValueType;
+
+  explicit SpscRingBuffer(const std::size_t capacity)
+      : mask_{units_internal::RoundUpToPowerOfTwo(capacity) - 1},
+        slots_(mask_ + 1, UnitT{ValueType{0}}) {}
+
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  NO_DISCARD auto capacity() const noexcept -> std::size_t {
+    return mask_ + 1;
+  }
+
+  // Producer. Returns false if the queue is full.
+  auto try_push(const UnitT u) noexcept -> bool {
+    return push(&u, 1) == 1;
+  }
+
+  // Producer. Pushes as many of the values as there is room for, in
+  // order, and returns the number of values pushed.
+  auto push(const UnitT* values, const std::size_t count) noexcept
+      -> std::size_t {
+    const auto tail = producer_.index.load(std::memory_order_relaxed);
+    if (producer_.cached + capacity() - tail < count) {
+      producer_.cached = consumer_.index.load(std::memory_order_acquire);
+    }
+    const auto n = std::min(count, producer_.cached + capacity() - tail);
+    for (std::size_t i = 0; i < n; ++i) {
+      slots_[(tail + i) & mask_] = values[i];
+    }
+    producer_.index.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer. Returns false if the queue is empty.
+  auto try_pop(UnitT& u) noexcept -> bool { return pop(&u, 1) == 1; }
+
+  // Consumer. Pops up to count values, in order, and returns the number
+  // of values popped.
+  auto pop(UnitT* values, const std::size_t count) noexcept -> std::size_t {
+    const auto head = consumer_.index.load(std::memory_order_relaxed);
+    if (consumer_.cached - head < count) {
+      consumer_.cached = producer_.index.load(std::memory_order_acquire);
+    }
+    const auto n = std::min(count, consumer_.cached - head);
+    for (std::size_t i = 0; i < n; ++i) {
+      values[i] = slots_[(head + i) & mask_];
+    }
+    consumer_.index.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+ private:
+  // Index written by one side, and that side's last seen value of the
+  // other side's index.
+  struct alignas(units_internal::kCacheLineSize) Side {
+    std::atomic<std::size_t> index{0};
+    std::size_t cached = 0;
+  };
+
+  std::size_t mask_;
+  std::vector<UnitT> slots_;
+  Side producer_;  // Tail.
+  Side consumer_;  // Head.
+};
+
+// Bounded queue for multiple producer threads and a single consumer
+// thread. Each slot has a sequence number that tells whether it is
+// ready to be written or read (D. Vyukov's bounded queue). Producers
+// are lock-free, the consumer is wait-free. The capacity is rounded up
+// to a power of two.
+template <typename UnitT>
+class MpscRingBuffer {
+ public:
+  using UnitType = UnitT;
+  using ValueType = typename UnitT::ValueType;
+
+  explicit MpscRingBuffer(const std::size_t capacity)
+      : mask_{units_internal::RoundUpToPowerOfTwo(capacity) - 1},
+        slots_{std::make_unique<Slot[]>(mask_ + 1)} {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingBuffer(const MpscRingBuffer&) = delete;
+  MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+  NO_DISCARD auto capacity() const noexcept -> std::size_t {
+    return mask_ + 1;
+  }
+
+  // Producer. Returns false if the queue is full.
+  auto try_push(const UnitT u) noexcept -> bool {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& slot = slots_[tail & mask_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == tail) {
+        if (tail_.compare_exchange_weak(tail, tail + 1,
+                                        std::memory_order_relaxed)) {
+          slot.value = u;
+          slot.sequence.store(tail + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < tail) {
+        return false;  // Full, the slot has not been read yet.
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Producer. Pushes values in order until the queue is full, returns
+  // the number of values pushed. Values from other producers may be
+  // interleaved.
+  auto push(const UnitT* values, const std::size_t count) noexcept
+      -> std::size_t {
+    std::size_t n = 0;
+    while (n < count && try_push(values[n])) {
+      ++n;
+    }
+    return n;
+  }
+
+  // Consumer. Returns false if the queue is empty.
+  auto try_pop(UnitT& u) noexcept -> bool { return pop(&u, 1) == 1; }
+
+  // Consumer. Pops up to count values and returns the number of values
+  // popped.
+  auto pop(UnitT* values, const std::size_t count) noexcept -> std::size_t {
+    std::size_t n = 0;
+    for (; n < count; ++n) {
+      auto& slot = slots_[(head_ + n) & mask_];
+      if (slot.sequence.load(std::memory_order_acquire) != head_ + n + 1) {
+        break;
+      }
+      values[n] = slot.value;
+      slot.sequence.store(head_ + n + capacity(),
+                          std::memory_order_release);
+    }
+    head_ += n;
+    return n;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence{0};
+    UnitT value{ValueType{0}};
+  };
+
+  std::size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(units_internal::kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  alignas(units_internal::kCacheLineSize) std::size_t head_ = 0;
+};
+
+#undef NO_DISCARD
+
+}  // namespace thinks
@@ -0,0 +1,487 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Streaming statistics and quantiles of units that can be merged across
+// threads.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thinks/units/units_core.h"
+#include "thinks/units/units_parallel.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+// Count, mean, variance, minimum and maximum of a stream of units in a
+// single pass and constant memory (Welford's algorithm). Statistics of
+// different parts of a stream, e.g. one per thread, are combined with
+// merge (Chan et al.), which gives the same result as pushing all values
+// to one instance up to rounding.
+//
+// The mean and standard deviation have the scale of the unit, the
+// variance is a unit of the squared dimension, e.g. [mm^2] for
+// millimeters. Statistics are accumulated in at least double precision,
+// single precision accumulators drift after a few million values.
+template <typename UnitT>
+class RunningStats {
+ public:
+  using UnitType = UnitT;
+  using ValueType = typename UnitT::ValueType;
+  using MeanValueType = units_internal::MeanValueType<ValueType>;
+  using MeanType = Unit<MeanValueType, typename UnitT::ScaleType,
+                        typename UnitT::TagType>;
+  using VarianceType =
+      decltype(std::declval<MeanType>() * std::declval<MeanType>());
+  using AccumulatorType = std::common_type_t<MeanValueType, double>;
+
+  // Number of values per block in batch pushes, small enough for the
+  // two passes over a block to hit cache.
+  static constexpr std::size_t kBlockSize = 1024;
+
+  NO_DISCARD auto count() const noexcept -> std::size_t { return count_; }
+
+  NO_DISCARD auto empty() const noexcept -> bool { return count_ == 0; }
+
+  // Must not be empty.
+  NO_DISCARD auto mean() const noexcept -> MeanType {
+    return MeanType{static_cast<MeanValueType>(mean_)};
+  }
+
+  // Population variance, zero if empty.
+  NO_DISCARD auto variance() const noexcept -> VarianceType {
+    return VarianceType{static_cast<MeanValueType>(
+        count_ == 0 ? AccumulatorType{0}
+                    : m2_ / static_cast<AccumulatorType>(count_))};
+  }
+
+  // Sample variance (Bessel's correction), zero if there are less than
+  // two values.
+  NO_DISCARD auto sample_variance() const noexcept -> VarianceType {
+    return VarianceType{static_cast<MeanValueType>(
+        count_ < 2 ? AccumulatorType{0}
+                   : m2_ / static_cast<AccumulatorType>(count_ - 1))};
+  }
+
+  NO_DISCARD auto stddev() const noexcept -> MeanType {
+    return MeanType{static_cast<MeanValueType>(std::sqrt(
+        count_ == 0 ? AccumulatorType{0}
+                    : m2_ / static_cast<AccumulatorType>(count_)))};
+  }
+
+  NO_DISCARD auto sample_stddev() const noexcept -> MeanType {
+    return MeanType{static_cast<MeanValueType>(std::sqrt(
+        count_ < 2 ? AccumulatorType{0}
+                   : m2_ / static_cast<AccumulatorType>(count_ - 1)))};
+  }
+
+  // Must not be empty.
+  NO_DISCARD auto min() const noexcept -> UnitT {
+    return UnitT{ValueType{min_}};
+  }
+
+  // Must not be empty.
+  NO_DISCARD auto max() const noexcept -> UnitT {
+    return UnitT{ValueType{max_}};
+  }
+
+  void push(const UnitT u) noexcept {
+    const ValueType v = u.value();
+    ++count_;
+    const auto delta = static_cast<AccumulatorType>(v) - mean_;
+    mean_ += delta / static_cast<AccumulatorType>(count_);
+    m2_ += delta * (static_cast<AccumulatorType>(v) - mean_);
+    min_ = v < min_ ? v : min_;
+    max_ = max_ < v ? v : max_;
+  }
+
+  // Push an array of values. Each block of values is summarized in two
+  // vectorizable passes (sum, then squared deviations from the block
+  // mean) and merged, which is faster and more accurate than pushing
+  // the values one at a time.
+  void push(const UnitT* values, const std::size_t count) noexcept {
+    for (std::size_t first = 0; first < count; first += kBlockSize) {
+      merge(Summarize(values + first, std::min(kBlockSize, count - first)));
+    }
+  }
+
+  // Push an array of values, blocks are summarized as tasks of the
+  // policy.
+  template <typename PolicyT>
+  auto push(PolicyT&& policy, const UnitT* values, const std::size_t count)
+      -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>> {
+    if (count == 0) {
+      return;
+    }
+    merge(units_internal::ChunkedReduce<RunningStats>(
+        policy, count,
+        [values](const std::size_t begin, const std::size_t end) {
+          RunningStats partial;
+          partial.push(values + begin, end - begin);
+          return partial;
+        },
+        [](RunningStats a, const RunningStats& b) {
+          a.merge(b);
+          return a;
+        }));
+  }
+
+  // Add the statistics of other values, in constant time.
+  void merge(const RunningStats& other) noexcept {
+    if (other.count_ == 0) {
+      return;
+    }
+    if (count_ == 0) {
+      *this = other;
+      return;
+    }
+    const auto n_a = static_cast<AccumulatorType>(count_);
+    const auto n_b = static_cast<AccumulatorType>(other.count_);
+    const auto n = n_a + n_b;
+    const auto delta = other.mean_ - mean_;
+    mean_ += delta * (n_b / n);
+    m2_ += other.m2_ + delta * delta * (n_a * n_b / n);
+    count_ += other.count_;
+    min_ = other.min_ < min_ ? other.min_ : min_;
+    max_ = max_ < other.max_ ? other.max_ : max_;
+  }
+
+  void clear() noexcept { *this = RunningStats{}; }
+
+ private:
+  // Statistics of a non-empty block of values.
+  NO_DISCARD static auto Summarize(const UnitT* values,
+                                   const std::size_t count) noexcept
+      -> RunningStats {
+    using units_internal::kLaneCount;
+    RunningStats s;
+    s.count_ = count;
+    s.mean_ = units_internal::SumKernel<AccumulatorType>(values, count) /
+              static_cast<AccumulatorType>(count);
+    AccumulatorType acc[kLaneCount] = {};
+    std::size_t i = 0;
+    for (; i + kLaneCount <= count; i += kLaneCount) {
+      for (std::size_t j = 0; j < kLaneCount; ++j) {
+        const auto d =
+            static_cast<AccumulatorType>(values[i + j].value()) - s.mean_;
+        acc[j] += d * d;
+      }
+    }
+    for (; i < count; ++i) {
+      const auto d =
+          static_cast<AccumulatorType>(values[i].value()) - s.mean_;
+      acc[i % kLaneCount] += d * d;
+    }
+    for (std::size_t n = kLaneCount / 2; n > 0; n /= 2) {
+      for (std::size_t j = 0; j < n; ++j) {
+        acc[j] += acc[j + n];
+      }
+    }
+    s.m2_ = acc[0];
+    const auto [lo, hi] = units_internal::MinMaxKernel(values, count);
+    s.min_ = lo.value();
+    s.max_ = hi.value();
+    return s;
+  }
+
+  std::size_t count_ = 0;
+  AccumulatorType mean_ = 0;
+  AccumulatorType m2_ = 0;  // Sum of squared deviations from the mean.
+  ValueType min_ = std::numeric_limits<ValueType>::max();
+  ValueType max_ = std::numeric_limits<ValueType>::lowest();
+};
+
+// Approximate quantiles of a stream of units in bounded memory, e.g.
+// the 95th percentile of gantry angle errors over millions of control
+// points (merging t-digest, Dunning and Ertl). Values are summarized as
+// weighted centroids, which are smaller near the extreme quantiles, such
+// that p99 is more accurate than p50 in terms of rank. The memory use is
+// proportional to the compression, which is roughly the maximum number
+// of centroids, independent of the number of values. The minimum and
+// maximum are exact.
+//
+// Sketches of different parts of a stream, e.g. one per thread, are
+// combined with merge. Quantiles have the scale of the unit, integer
+// values are interpolated in double precision.
+template <typename UnitT>
+class QuantileSketch {
+ public:
+  using UnitType = UnitT;
+  using ValueType = typename UnitT::ValueType;
+  using MeanValueType = units_internal::MeanValueType<ValueType>;
+  using QuantileType = Unit<MeanValueType, typename UnitT::ScaleType,
+                            typename UnitT::TagType>;
+  using AccumulatorType = std::common_type_t<MeanValueType, double>;
+
+  static constexpr double kDefaultCompression = 200;
+
+  // Values are buffered and sorted into the centroids when the buffer
+  // is full.
+  static constexpr std::size_t kBufferFactor = 8;
+
+  explicit QuantileSketch(const double compression = kDefaultCompression)
+      : compression_{std::max(compression, 10.0)},
+        buffer_capacity_{kBufferFactor *
+                         static_cast<std::size_t>(compression_)} {
+    centroids_.reserve(static_cast<std::size_t>(compression_) + 1);
+    scratch_.reserve(centroids_.capacity());
+    buffer_.reserve(buffer_capacity_);
+  }
+
+  NO_DISCARD auto compression() const noexcept -> double {
+    return compression_;
+  }
+
+  NO_DISCARD auto count() const noexcept -> std::size_t { return count_; }
+
+  NO_DISCARD auto empty() const noexcept -> bool { return count_ == 0; }
+
+  // Must not be empty.
+  NO_DISCARD auto min() const noexcept -> UnitT {
+    return UnitT{ValueType{min_}};
+  }
+
+  // Must not be empty.
+  NO_DISCARD auto max() const noexcept -> UnitT {
+    return UnitT{ValueType{max_}};
+  }
+
+  // Number of centroids after buffered values have been merged, which
+  // is bounded by the compression.
+  NO_DISCARD auto centroid_count() -> std::size_t {
+    Compress();
+    return centroids_.size();
+  }
+
+  void push(const UnitT u) {
+    const ValueType v = u.value();
+    min_ = v < min_ ? v : min_;
+    max_ = max_ < v ? v : max_;
+    ++count_;
+    buffer_.push_back(static_cast<AccumulatorType>(v));
+    if (buffer_.size() == buffer_capacity_) {
+      Compress();
+    }
+  }
+
+  void push(const UnitT* values, const std::size_t count) {
+    for (std::size_t first = 0; first < count;) {
+      const auto n =
+          std::min(count - first, buffer_capacity_ - buffer_.size());
+      const auto [lo, hi] = units_internal::MinMaxKernel(values + first, n);
+      min_ = lo.value() < min_ ? lo.value() : min_;
+      max_ = max_ < hi.value() ? hi.value() : max_;
+      for (std::size_t i = first; i < first + n; ++i) {
+        buffer_.push_back(static_cast<AccumulatorType>(values[i].value()));
+      }
+      count_ += n;
+      first += n;
+      if (buffer_.size() == buffer_capacity_) {
+        Compress();
+      }
+    }
+  }
+
+  // Push an array of values, chunks are sketched as tasks of the policy
+  // and merged.
+  template <typename PolicyT>
+  auto push(PolicyT&& policy, const UnitT* values, const std::size_t count)
+      -> std::enable_if_t<units_internal::is_execution_policy_v<PolicyT>> {
+    if (count == 0) {
+      return;
+    }
+    merge(units_internal::ChunkedReduce<QuantileSketch>(
+        policy, count,
+        [this, values](const std::size_t begin, const std::size_t end) {
+          QuantileSketch partial(compression_);
+          partial.push(values + begin, end - begin);
+          return partial;
+        },
+        [](QuantileSketch a, const QuantileSketch& b) {
+          a.merge(b);
+          return a;
+        }));
+  }
+
+  // Add the values summarized by another sketch, the result has the
+  // compression of this sketch.
+  void merge(const QuantileSketch& other) {
+    if (other.count_ == 0) {
+      return;
+    }
+    min_ = other.min_ < min_ ? other.min_ : min_;
+    max_ = max_ < other.max_ ? other.max_ : max_;
+    count_ += other.count_;
+
+    // Compress all centroids and values in one pass, compressing twice
+    // doubles the error.
+    std::vector<Centroid> centroids;
+    centroids.reserve(centroids_.size() + other.centroids_.size());
+    std::merge(centroids_.begin(), centroids_.end(),
+               other.centroids_.begin(), other.centroids_.end(),
+               std::back_inserter(centroids),
+               [](const Centroid& lhs, const Centroid& rhs) {
+                 return lhs.mean < rhs.mean;
+               });
+    centroids_.swap(centroids);
+    buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+    std::sort(buffer_.begin(), buffer_.end());
+    Rebuild(centroids_.begin(), centroids_.end(), buffer_.begin(),
+            buffer_.end());
+    buffer_.clear();
+  }
+
+  // Approximate value at quantile q in [0, 1], e.g. 0.95 for the 95th
+  // percentile. Must not be empty.
+  NO_DISCARD auto quantile(const double q) -> QuantileType {
+    Compress();
+    return QuantileType{static_cast<MeanValueType>(Quantile(q))};
+  }
+
+  void clear() noexcept {
+    centroids_.clear();
+    buffer_.clear();
+    count_ = 0;
+    min_ = std::numeric_limits<ValueType>::max();
+    max_ = std::numeric_limits<ValueType>::lowest();
+  }
+
+ private:
+  struct Centroid {
+    AccumulatorType mean;
+    AccumulatorType weight;
+  };
+
+  // Scale function k(q), centroids may span at most one unit of k. The
+  // arcsine makes centroids small near q = 0 and q = 1.
+  NO_DISCARD auto K(const double q) const noexcept -> double {
+    return compression_ / (2 * units_internal::kPi.hi) * std::asin(2 * q - 1);
+  }
+  NO_DISCARD auto KInverse(const double k) const noexcept -> double {
+    const auto x = std::min(k * 2 * units_internal::kPi.hi / compression_,
+                            units_internal::kPi.hi / 2);
+    return (std::sin(x) + 1) / 2;
+  }
+
+  // Sort the buffered values into the centroids.
+  void Compress() {
+    if (buffer_.empty()) {
+      return;
+    }
+    std::sort(buffer_.begin(), buffer_.end());
+    Rebuild(centroids_.begin(), centroids_.end(), buffer_.begin(),
+            buffer_.end());
+    buffer_.clear();
+  }
+
+  NO_DISCARD static auto AsCentroid(const Centroid& c) noexcept
+      -> Centroid {
+    return c;
+  }
+  NO_DISCARD static auto AsCentroid(const AccumulatorType v) noexcept
+      -> Centroid {
+    return Centroid{v, 1};
+  }
+
+  // Replace the centroids by merging two sequences of centroids or
+  // values sorted by their means, with a total weight of count_. Each
+  // centroid grows until it spans one unit of the scale function.
+  template <typename Iter1, typename Iter2>
+  void Rebuild(Iter1 a, const Iter1 a_end, Iter2 b, const Iter2 b_end) {
+    const auto total = static_cast<double>(count_);
+    scratch_.clear();
+    auto current = a != a_end ? AsCentroid(*a++) : AsCentroid(*b++);
+    double weight_so_far = 0;
+    double q_limit = KInverse(K(0) + 1);
+    while (a != a_end || b != b_end) {
+      const auto next =
+          b == b_end || (a != a_end && AsCentroid(*a).mean <=
+                                           AsCentroid(*b).mean)
+              ? AsCentroid(*a++)
+              : AsCentroid(*b++);
+      const auto weight = current.weight + next.weight;
+      if ((weight_so_far + weight) / total <= q_limit) {
+        current.mean += (next.mean - current.mean) * (next.weight / weight);
+        current.weight = weight;
+      } else {
+        weight_so_far += current.weight;
+        scratch_.push_back(current);
+        q_limit = KInverse(K(weight_so_far / total) + 1);
+        current = next;
+      }
+    }
+    scratch_.push_back(current);
+    centroids_.swap(scratch_);
+  }
+
+  // Interpolate between centroid means, where each centroid is centered
+  // on its weight, and towards the exact minimum and maximum in the
+  // outer halves of the first and last centroids.
+  NO_DISCARD auto Quantile(const double q) const noexcept
+      -> AccumulatorType {
+    const auto lo = static_cast<AccumulatorType>(min_);
+    const auto hi = static_cast<AccumulatorType>(max_);
+    const auto n = static_cast<AccumulatorType>(count_);
+    const auto index = static_cast<AccumulatorType>(q) * n;
+    if (centroids_.size() == 1 || index <= 0) {
+      return index <= 0 ? lo : Lerp(lo, hi, q);
+    }
+    if (index >= n) {
+      return hi;
+    }
+
+    const auto& first = centroids_.front();
+    if (index < first.weight / 2) {
+      return Lerp(lo, first.mean, index / (first.weight / 2));
+    }
+    const auto& last = centroids_.back();
+    if (n - index <= last.weight / 2) {
+      return Lerp(hi, last.mean, (n - index) / (last.weight / 2));
+    }
+
+    auto weight_so_far = first.weight / 2;
+    for (std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+      const auto dw = (centroids_[i].weight + centroids_[i + 1].weight) / 2;
+      if (index < weight_so_far + dw) {
+        return Lerp(centroids_[i].mean, centroids_[i + 1].mean,
+                    (index - weight_so_far) / dw);
+      }
+      weight_so_far += dw;
+    }
+    return last.mean;
+  }
+
+  NO_DISCARD static auto Lerp(const AccumulatorType a,
+                              const AccumulatorType b,
+                              const AccumulatorType t) noexcept
+      -> AccumulatorType {
+    return a + (b - a) * t;
+  }
+
+  double compression_;
+  std::size_t buffer_capacity_;
+  std::vector<Centroid> centroids_;  // Sorted by mean.
+  std::vector<Centroid> scratch_;
+  std::vector<AccumulatorType> buffer_;  // Values not yet in centroids.
+  std::size_t count_ = 0;
+  ValueType min_ = std::numeric_limits<ValueType>::max();
+  ValueType max_ = std::numeric_limits<ValueType>::lowest();
+};
+
+#undef NO_DISCARD
+
+}  // namespace thinks
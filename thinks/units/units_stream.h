@@ -0,0 +1,306 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Streaming conversion of units using C++20 coroutines, for data sets
+// that do not fit in memory.
+
+#pragma once
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 202002L) && defined(__cpp_impl_coroutine) && \
+    __has_include(<coroutine>)
+  #define THINKS_UNITS_HAS_COROUTINES 1
+#else
+  #define THINKS_UNITS_HAS_COROUTINES 0
+#endif
+
+#if THINKS_UNITS_HAS_COROUTINES
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define NO_DISCARD [[nodiscard]]
+
+namespace thinks {
+
+// Minimal generator, an input range of the values yielded by a
+// coroutine. Values are references to objects owned by the coroutine,
+// valid until the iterator is incremented.
+template <typename T>
+class Generator {
+ public:
+  struct promise_type {
+    const T* value = nullptr;
+    std::exception_ptr exception;
+
+    auto get_return_object() noexcept -> Generator {
+      return Generator{Handle::from_promise(*this)};
+    }
+    auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+    auto final_suspend() noexcept -> std::suspend_always { return {}; }
+    auto yield_value(const T& v) noexcept -> std::suspend_always {
+      value = &v;
+      return {};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+
+    Iterator() noexcept = default;
+    explicit Iterator(const Handle h) noexcept : h_{h} {}
+
+    auto operator++() -> Iterator& {
+      Resume(h_);
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    NO_DISCARD auto operator*() const noexcept -> const T& {
+      return *h_.promise().value;
+    }
+    NO_DISCARD friend auto operator==(const Iterator& it,
+                                      std::default_sentinel_t) noexcept
+        -> bool {
+      return it.h_.done();
+    }
+
+   private:
+    Handle h_ = nullptr;
+  };
+
+  Generator(Generator&& other) noexcept
+      : h_{std::exchange(other.h_, nullptr)} {}
+  Generator& operator=(Generator&& other) noexcept {
+    if (this != &other) {
+      if (h_) {
+        h_.destroy();
+      }
+      h_ = std::exchange(other.h_, nullptr);
+    }
+    return *this;
+  }
+  Generator(const Generator&) = delete;
+  Generator& operator=(const Generator&) = delete;
+
+  ~Generator() {
+    if (h_) {
+      h_.destroy();
+    }
+  }
+
+  // Starts the coroutine, may only be called once.
+  NO_DISCARD auto begin() -> Iterator {
+    Resume(h_);
+    return Iterator{h_};
+  }
+  NO_DISCARD auto end() const noexcept -> std::default_sentinel_t {
+    return {};
+  }
+
+ private:
+  explicit Generator(const Handle h) noexcept : h_{h} {}
+
+  // Exceptions thrown in the coroutine are rethrown to the consumer.
+  static void Resume(const Handle h) {
+    h.resume();
+    if (h.done() && h.promise().exception) {
+      std::rethrow_exception(h.promise().exception);
+    }
+  }
+
+  Handle h_;
+};
+
+namespace units_internal {
+
+// Convert raw values, which are interpreted as values in the scale of
+// the target unit, or units with any scale and the same tag.
+template <typename ToUnitT, typename FromT>
+void StreamConvert(const FromT* from, const std::size_t count, ToUnitT* to) {
+  if constexpr (std::is_arithmetic_v<FromT>) {
+    using ToArithT = typename ToUnitT::ValueType;
+    for (std::size_t i = 0; i < count; ++i) {
+      to[i] = ToUnitT{static_cast<ToArithT>(from[i])};
+    }
+  } else {
+    unit_cast(from, count, to);
+  }
+}
+
+// Reads chunks from a source into two buffers on a dedicated thread,
+// such that the next chunk is read while the current chunk is used. A
+// new read starts as soon as a buffer is released.
+template <typename T, typename SourceT>
+class ChunkReader {
+ public:
+  ChunkReader(SourceT& source, const std::size_t chunk_size, const T& zero)
+      : source_{source},
+        chunk_size_{chunk_size},
+        buffers_{std::vector<T>(chunk_size, zero),
+                 std::vector<T>(chunk_size, zero)},
+        thread_{[this]() { Run(); }} {}
+
+  ChunkReader(const ChunkReader&) = delete;
+  ChunkReader& operator=(const ChunkReader&) = delete;
+
+  // Waits for a pending read to finish, the source is not interrupted.
+  ~ChunkReader() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+
+  // Waits for the next chunk, which is empty at the end of the stream.
+  // Exceptions thrown by the source are rethrown. The previous chunk
+  // must have been released.
+  NO_DISCARD auto next() -> std::span<const T> {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return full_[current_]; });
+    if (counts_[current_] == 0 && error_) {
+      std::rethrow_exception(error_);
+    }
+    return std::span<const T>(buffers_[current_].data(), counts_[current_]);
+  }
+
+  // Allow the buffer of the current chunk to be reused.
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      full_[current_] = false;
+    }
+    cv_.notify_all();
+    current_ = 1 - current_;
+  }
+
+ private:
+  void Run() {
+    for (std::size_t b = 0;; b = 1 - b) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this, b]() { return stop_ || !full_[b]; });
+        if (stop_) {
+          return;
+        }
+      }
+      std::size_t count = 0;
+      std::exception_ptr error;
+      try {
+        count = static_cast<std::size_t>(source_(buffers_[b].data(),
+                                                 chunk_size_));
+      } catch (...) {
+        error = std::current_exception();
+      }
+      if (count > chunk_size_) {
+        // Also catches negative counts. The values written past the
+        // buffer cannot be undone, but are never read.
+        error = std::make_exception_ptr(std::length_error(
+            "stream source returned more values than requested"));
+        count = 0;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counts_[b] = count;
+        full_[b] = true;
+        error_ = error;
+      }
+      cv_.notify_all();
+      if (count == 0) {
+        return;
+      }
+    }
+  }
+
+  SourceT& source_;
+  std::size_t chunk_size_;
+  std::vector<T> buffers_[2];
+  std::size_t counts_[2] = {0, 0};
+  bool full_[2] = {false, false};
+  std::size_t current_ = 0;  // Consumer.
+  bool stop_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;  // Last, started when all members are initialized.
+};
+
+}  // namespace units_internal
+
+inline constexpr std::size_t kDefaultStreamChunkSize = std::size_t{1} << 16;
+
+// Stream values from a source in chunks, converted to ToUnitT. The source
+// is called as source(FromT* data, std::size_t max_count) and returns the
+// number of values written, zero at the end of the stream. Returning
+// more than max_count ends the stream with std::length_error. FromT is
+// either a unit with the same tag as ToUnitT or an arithmetic type,
+// whose values are taken to be in the scale of ToUnitT.
+//
+// Chunks are read on a separate thread, such that the next chunk is read
+// while the current chunk is converted and consumed. Calls to the source
+// are never concurrent. At most two chunks of FromT and one chunk of
+// ToUnitT are held in memory. Each yielded span is valid until the
+// generator is resumed.
+template <typename ToUnitT, typename FromT = ToUnitT, typename SourceT>
+NO_DISCARD auto stream_cast(
+    SourceT source,
+    const std::size_t chunk_size = kDefaultStreamChunkSize)
+    -> Generator<std::span<const ToUnitT>> {
+  constexpr bool kSameType = std::is_same_v<FromT, ToUnitT>;
+  const auto zero = [] {
+    if constexpr (std::is_arithmetic_v<FromT>) {
+      return FromT{0};
+    } else {
+      return FromT{typename FromT::ValueType{0}};
+    }
+  };
+  std::vector<ToUnitT> converted(
+      kSameType ? 0 : chunk_size, ToUnitT{typename ToUnitT::ValueType{0}});
+  units_internal::ChunkReader<FromT, SourceT> reader(source, chunk_size,
+                                                     zero());
+  for (;;) {
+    const auto chunk = reader.next();
+    if (chunk.empty()) {
+      break;
+    }
+    if constexpr (kSameType) {
+      co_yield chunk;
+      reader.release();
+    } else {
+      // Release the source chunk before yielding, the next read then
+      // overlaps with the consumer.
+      units_internal::StreamConvert(chunk.data(), chunk.size(),
+                                    converted.data());
+      reader.release();
+      co_yield std::span<const ToUnitT>(converted.data(), chunk.size());
+    }
+  }
+}
+
+#undef NO_DISCARD
+
+}  // namespace thinks
+
+#endif  // THINKS_UNITS_HAS_COROUTINES
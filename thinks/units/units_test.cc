@@ -4,19 +4,80 @@
 
 #define _USE_MATH_DEFINES  // M_PI
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <clocale>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <locale>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "thinks/units/units.h"
 
+// User-defined tags and scales, registered without editing units.h.
+struct MassBase;
+struct MonitorUnitBase;
+THINKS_UNITS_BASE_DIMENSION(MassBase, "mass")
+THINKS_UNITS_BASE_DIMENSION(MonitorUnitBase, "monitor_unit")
+using MassTag = thinks::BaseTag<MassBase>;
+using MonitorUnitTag = thinks::BaseTag<MonitorUnitBase>;
+
+using KilogramScale = std::ratio<1>::type;
+using GramScale = std::ratio<1, 1000>::type;
+using MonitorUnitScale = std::ratio<1>::type;
+using MicrogramScale = std::ratio<1, 1000000000>::type;
+THINKS_UNITS_SUFFIX(KilogramScale, MassTag, "kg")
+THINKS_UNITS_SUFFIX(GramScale, MassTag, "g")
+THINKS_UNITS_SUFFIX(MonitorUnitScale, MonitorUnitTag, "MU")
+// Suffixes are not limited in length.
+THINKS_UNITS_SUFFIX(MicrogramScale, MassTag,
+                    "micrograms_micrograms_micrograms_micrograms_micrograms_"
+                    "micrograms_micrograms_micrograms_micrograms_micrograms_"
+                    "micrograms_micrograms_micrograms_micrograms")
+THINKS_UNITS_TAG_SCALES(MassTag, KilogramScale, GramScale, MicrogramScale)
+THINKS_UNITS_TAG_SCALES(MonitorUnitTag, MonitorUnitScale)
+THINKS_UNITS_USER_TAGS(MassTag, MonitorUnitTag)
+
+// Additional scales for a built-in tag.
+using LengthTag = thinks::Centimeters<int>::TagType;
+using InchScale = std::ratio<254, 100>::type;
+using PicometerScale = std::ratio<1, 10000000000>::type;
+THINKS_UNITS_SUFFIX(InchScale, LengthTag, "in")
+THINKS_UNITS_SUFFIX(PicometerScale, LengthTag, "pm")
+THINKS_UNITS_TAG_SCALES(LengthTag, InchScale, PicometerScale)
+
+template <typename ArithT>
+using Kilograms = thinks::Unit<ArithT, KilogramScale, MassTag>;
+template <typename ArithT>
+using Grams = thinks::Unit<ArithT, GramScale, MassTag>;
+template <typename ArithT>
+using MonitorUnits = thinks::Unit<ArithT, MonitorUnitScale, MonitorUnitTag>;
+template <typename ArithT>
+using Micrograms = thinks::Unit<ArithT, MicrogramScale, MassTag>;
+template <typename ArithT>
+using Inches = thinks::Unit<ArithT, InchScale, LengthTag>;
+template <typename ArithT>
+using Picometers = thinks::Unit<ArithT, PicometerScale, LengthTag>;
+
+namespace user_literals {
+THINKS_UNITS_LITERAL(Kilograms, _kg)
+THINKS_UNITS_LITERAL(Grams, _g)
+THINKS_UNITS_LITERAL(MonitorUnits, _MU)
+}  // namespace user_literals
+
 // Check compile-time constructs.
 constexpr bool StaticTests() {
   using namespace thinks::unit_literals;
@@ -78,12 +139,114 @@ constexpr bool StaticTests() {
     static_assert(50_mm == 5_cm, "different scale");
     static_assert(5.0_mm != 7_mm, "different value types");
     static_assert(41_mm != 4_cm, "different scale");
+    static_assert(4_cm != 41_mm, "no truncation of either side");
 
     // Not possible to compare units with different tags.
     // The following doesn't compile.
     // constexpr bool x = 5_cm == 5_deg;
   }
 
+  // Ordering comparison.
+  {
+    static_assert(5_mm < 7_mm && 7_mm > 5_mm, "");
+    static_assert(5_mm <= 5_mm && 5_mm >= 5_mm, "");
+    static_assert(41_mm > 4_cm && 4_cm < 41_mm, "different scale");
+    static_assert(40_mm <= 4_cm && 4_cm >= 40_mm, "different scale");
+    static_assert(4.1_cm > 40_mm && 4.1_cm < 42_mm, "different value types");
+    static_assert(!(1_m < 100_cm) && !(1_m > 100_cm), "");
+
+    // Integers compare exactly, even when the scaled values do not fit
+    // in the value type.
+    constexpr auto kBig = std::numeric_limits<std::int64_t>::max();
+    static_assert(thinks::Meters<std::int64_t>{std::int64_t{kBig}} >
+                      thinks::Millimeters<std::int64_t>{std::int64_t{kBig}},
+                  "");
+    static_assert(thinks::Meters<std::uint8_t>{std::uint8_t{3}} >
+                      thinks::Centimeters<std::uint8_t>{std::uint8_t{255}},
+                  "");
+
+    // Large ratios widen beyond 64 bits, also for narrow value types.
+    constexpr auto kIntMax = std::numeric_limits<int>::max();
+    constexpr auto kIntMin = std::numeric_limits<int>::min();
+    static_assert(Picometers<int>{6} < thinks::Meters<int>{100001}, "");
+    static_assert(Picometers<int>{int{kIntMax}} < thinks::Meters<int>{1} &&
+                      Picometers<int>{int{kIntMax}} > thinks::Meters<int>{0},
+                  "");
+    static_assert(thinks::Meters<int>{int{kIntMax}} >
+                      Picometers<int>{int{kIntMax}},
+                  "");
+    static_assert(thinks::Meters<int>{int{kIntMin}} <
+                      Picometers<int>{int{kIntMin}},
+                  "");
+    static_assert(thinks::Meters<std::int64_t>{std::int64_t{kBig}} >
+                      Picometers<std::int64_t>{std::int64_t{kBig}},
+                  "");
+    static_assert(Picometers<std::int64_t>{std::int64_t{1000000000000}} ==
+                      thinks::Meters<int>{1},
+                  "");
+    static_assert(Picometers<std::uint64_t>{
+                      std::numeric_limits<std::uint64_t>::max()} <
+                      thinks::Meters<int>{18446745},
+                  "");
+
+    // Floating point values fold the ratio into one multiplication.
+    static_assert(0.3_m == 300.0_mm && 300.0_mm == 0.3_m, "");
+    static_assert(Picometers<double>{1e12} == thinks::Meters<double>{1.0},
+                  "");
+
+    // Irrational scale ratios.
+    static_assert(1_rad > 57_deg && 1_rad < 58_deg, "");
+    static_assert(180_deg < 3.1416_rad && 180_deg > 3.1415_rad, "");
+
+#if defined(__cpp_impl_three_way_comparison) && \
+    defined(__cpp_lib_three_way_comparison)
+    static_assert((41_mm <=> 4_cm) > 0, "");
+    static_assert((40_mm <=> 4_cm) == 0, "");
+    static_assert((1.0_cm <=> 11_mm) < 0, "");
+#endif
+
+    // Not possible to order units with different tags.
+    // The following doesn't compile.
+    // constexpr bool x = 5_cm < 5_deg;
+  }
+
+  // Common unit, min/max/clamp.
+  {
+    static_assert(std::is_same_v<thinks::common_unit_t<thinks::Meters<int>,
+                                                       thinks::Millimeters<int>>,
+                                 thinks::Millimeters<int>>,
+                  "");
+    static_assert(
+        std::is_same_v<thinks::common_unit_t<thinks::Meters<float>,
+                                             thinks::Centimeters<double>>,
+                       thinks::Centimeters<double>>,
+        "");
+    static_assert(
+        std::is_same_v<thinks::common_unit_t<thinks::Meters<int>,
+                                             thinks::Centimeters<int>,
+                                             thinks::Millimeters<short>>,
+                       thinks::Millimeters<int>>,
+        "");
+    static_assert(std::is_same_v<thinks::common_unit_t<thinks::Gray<float>,
+                                                       thinks::CentiGray<float>>,
+                                 thinks::CentiGray<float>>,
+                  "");
+    // Mixed powers of pi, no exact common scale exists.
+    static_assert(std::is_same_v<thinks::common_unit_t<thinks::Radians<double>,
+                                                       thinks::Degrees<double>>,
+                                 thinks::Degrees<double>>,
+                  "");
+
+    static_assert(thinks::min(1_m, 990_mm) == 990_mm, "");
+    static_assert(thinks::max(1_m, 990_mm) == 1000_mm, "");
+    static_assert(
+        std::is_same_v<decltype(thinks::min(1.0_m, 990_mm).value()), double>,
+        "");
+    static_assert(thinks::clamp(5_cm, 1_mm, 2_cm) == 20_mm, "");
+    static_assert(thinks::clamp(5_cm, 60_mm, 1_m) == 6_cm, "");
+    static_assert(thinks::clamp(5_cm, 1_mm, 1_m) == 50_mm, "");
+  }
+
   // Arithmetic operations.
   {
     // Value type promotion follows the normal rules for built-in types.
@@ -145,6 +308,205 @@ constexpr bool StaticTests() {
     // 12.3_mm + 3.2_mm;
   }
 
+  // Dimensional analysis.
+  {
+    // Multiplying lengths gives areas and volumes, the scale of the result
+    // is the product of the scales, e.g. [mm] * [mm] -> [mm^2].
+    static_assert(std::is_same_v<decltype(2_mm * 3_mm),
+                                 thinks::SquareMillimeters<long long>>,
+                  "");
+    static_assert(std::is_same_v<decltype(2.0_cm * 3_cm * 4_cm),
+                                 thinks::CubicCentimeters<double>>,
+                  "");
+    static_assert(2_mm * 3_mm == thinks::SquareMillimeters<int>{6}, "");
+    static_assert(2_cm * 3_cm == thinks::SquareMillimeters<int>{600}, "");
+
+    // The result is identical to raw arithmetic on the values, and units
+    // have the same layout as their values.
+    static_assert((1.5_mm * 2.5_mm).value() == 1.5 * 2.5, "");
+    static_assert((1.5_Gy / 2.5_mm).value() == 1.5 / 2.5, "");
+    static_assert(sizeof(thinks::SquareMillimeters<float>) == sizeof(float),
+                  "");
+    static_assert(
+        std::is_trivially_copyable_v<thinks::SquareMillimeters<float>>, "");
+
+    // Dimensions are canonical, regardless of the order of operations.
+    static_assert(std::is_same_v<decltype(1_Gy * 1_mm), decltype(1_mm * 1_Gy)>,
+                  "");
+    static_assert(std::is_same_v<decltype(1_Gy / 1_mm * 1_mm),
+                                 decltype(1_Gy * 1_mm / 1_mm)>,
+                  "");
+    static_assert(std::is_same_v<decltype(1_Gy / 1_mm * 1_mm), 
+                                 thinks::Gray<long long>>,
+                  "");
+
+    // Division by a unit with a different scale but the same tag cancels
+    // dimensions as before, units with different tags give derived units.
+    static_assert(std::is_same_v<decltype(6_mm * 2_mm / 3_mm),
+                                 thinks::Millimeters<long long>>,
+                  "");
+    static_assert(6_cm * 2_cm / 3_mm == 40_cm, "");
+
+    // Dimensions that cancel out give scalars.
+    static_assert(std::is_same_v<decltype((1_Gy / 1_mm) * 1_mm / 1_Gy),
+                                 long long>,
+                  "");
+    static_assert((10.0_Gy / 2_mm) * (1.0 / (1_mm / 1_mm)) * 2_cm == 100.0_Gy,
+                  "");
+  }
+
+  // Time and rates.
+  {
+    static_assert(1_s == 1000_ms, "");
+    static_assert(std::is_same_v<decltype(2.0_Gy / 4_s),
+                                 thinks::GrayPerSecond<double>>,
+                  "");
+    static_assert(std::is_same_v<decltype(90.0_deg / 1_s),
+                                 thinks::DegreesPerSecond<double>>,
+                  "");
+    static_assert(2.0_Gy / 4_s == thinks::GrayPerSecond<double>{0.5}, "");
+
+    // Integration, rate * dt is a dose, with a scale that depends on dt.
+    constexpr auto rate = thinks::GrayPerSecond<float>{2.f};
+    static_assert(std::is_same_v<decltype(rate * thinks::Seconds<float>{3.f}),
+                                 thinks::Gray<float>>,
+                  "");
+    static_assert(rate * thinks::Seconds<float>{3.f} == 6_Gy, "");
+    static_assert(rate * 500_ms == 1_Gy, "");
+
+    // std::chrono bridging keeps value type and scale.
+    static_assert(
+        std::is_same_v<decltype(thinks::from_duration(
+                           std::chrono::milliseconds{5})),
+                       thinks::Milliseconds<std::chrono::milliseconds::rep>>,
+        "");
+    static_assert(thinks::from_duration(std::chrono::milliseconds{5}) == 5_ms,
+                  "");
+    static_assert(thinks::to_duration(2_s) == std::chrono::seconds{2}, "");
+    static_assert(thinks::to_duration(thinks::unit_cast<thinks::Seconds<double>>(
+                      1500.0_ms)) == std::chrono::duration<double>{1.5},
+                  "");
+    static_assert(rate * std::chrono::milliseconds{500} == 1_Gy, "");
+    static_assert(180.0_deg / std::chrono::seconds{2} ==
+                      thinks::DegreesPerSecond<double>{90.0},
+                  "");
+  }
+
+  // Radians and degrees, scales that include pi.
+  {
+    // Conversion factors are correctly rounded constants.
+    static_assert(thinks::unit_cast<thinks::Degrees<double>>(1.0_rad) ==
+                      thinks::Degrees<double>{57.295779513082323},
+                  "");
+    static_assert(thinks::unit_cast<thinks::Radians<double>>(1.0_deg) ==
+                      thinks::Radians<double>{0.017453292519943295},
+                  "");
+    static_assert(thinks::unit_cast<thinks::Radians<float>>(
+                      thinks::Degrees<float>{1.f}) ==
+                      thinks::Radians<float>{0.0174532924f},
+                  "");
+
+    static_assert(thinks::unit_cast<thinks::Radians<double>>(180.0_deg) ==
+                      thinks::Radians<double>{M_PI},
+                  "");
+    static_assert(thinks::unit_cast<thinks::Degrees<double>>(
+                      thinks::Radians<double>{M_PI}) == 180.0_deg,
+                  "");
+
+    // Integers are scaled in floating point, no overflow.
+    static_assert(thinks::unit_cast<thinks::Degrees<int>>(
+                      thinks::Radians<int>{3}) == 171_deg,
+                  "");
+    static_assert(thinks::unit_cast<thinks::Radians<double>>(180_deg) ==
+                      thinks::Radians<double>{M_PI},
+                  "");
+
+    // Integer values are converted before scaling.
+    static_assert(thinks::unit_cast<thinks::Centimeters<double>>(15_mm) ==
+                      1.5_cm,
+                  "");
+  }
+
+  // Scales with large factors.
+  {
+    // The ratio between these scales (2^-124) does not fit in a 
+    // std::ratio, the conversion falls back to a floating point factor
+    // instead of failing to compile.
+    using TinyScale = std::ratio<1, std::intmax_t{1} << 62>;
+    using HugeScale = std::ratio<std::intmax_t{1} << 62>;
+    using Tiny = thinks::Unit<double, TinyScale,
+                              thinks::units_internal::LengthTag>;
+    using Huge = thinks::Unit<double, HugeScale,
+                              thinks::units_internal::LengthTag>;
+    constexpr double kTwoPow124 = 21267647932558653966460912964485513216.0;
+    static_assert(thinks::unit_cast<Huge>(Tiny{double{kTwoPow124}}) == Huge{1.0}, "");
+    static_assert(thinks::unit_cast<Tiny>(Huge{1.0}) == Tiny{double{kTwoPow124}}, "");
+    static_assert(Huge{1.0} == Tiny{double{kTwoPow124}}, "");
+
+    // Products reduce common factors before multiplying.
+    static_assert(
+        std::is_same_v<thinks::units_internal::ScaleMultiply<HugeScale,
+                                                             TinyScale>,
+                       std::ratio<1>>,
+        "");
+
+    // Doesn't compile, the product scale is not representable:
+    // using X = thinks::units_internal::ScaleMultiply<HugeScale, HugeScale>;
+  }
+
+  // Fingerprints.
+  {
+    // Differ in scale, value type and tag, respectively.
+    static_assert(thinks::unit_fingerprint_v<thinks::Millimeters<float>> !=
+                      thinks::unit_fingerprint_v<thinks::Centimeters<float>>,
+                  "");
+    static_assert(thinks::unit_fingerprint_v<thinks::Millimeters<float>> !=
+                      thinks::unit_fingerprint_v<thinks::Millimeters<double>>,
+                  "");
+    static_assert(
+        thinks::unit_fingerprint_v<thinks::Millimeters<std::int32_t>> !=
+            thinks::unit_fingerprint_v<thinks::Millimeters<std::uint32_t>>,
+        "");
+    static_assert(thinks::unit_fingerprint_v<thinks::Degrees<float>> !=
+                      thinks::unit_fingerprint_v<thinks::Gray<float>>,
+                  "");
+    // Value types of the same size and signedness.
+    static_assert(
+        thinks::unit_fingerprint_v<thinks::Millimeters<bool>> !=
+            thinks::unit_fingerprint_v<thinks::Millimeters<unsigned char>>,
+        "");
+    static_assert(
+        thinks::unit_fingerprint_v<thinks::Millimeters<long double>> !=
+            thinks::unit_fingerprint_v<thinks::Millimeters<double>>,
+        "");
+    static_assert(thinks::serialized_size<thinks::Gray<float>>(3) == 16 + 12,
+                  "");
+  }
+
+#if (__cplusplus >= 202002L) && defined(__cpp_nontype_template_args) && \
+    (__cpp_nontype_template_args >= 201911L)
+  // Compile-time parsing.
+  {
+    // Unit type from suffix, value type follows the literal rules.
+    static_assert(std::is_same_v<decltype(thinks::parse<"12.3 mm">()),
+                                 thinks::Millimeters<double>>,
+                  "");
+    static_assert(std::is_same_v<decltype(thinks::parse<"12 cGy">()),
+                                 thinks::CentiGray<long long>>,
+                  "");
+    static_assert(thinks::parse<"12.3 mm">() == 12.3_mm, "");
+    static_assert(thinks::parse<"12 cGy">() == 12_cGy, "");
+    static_assert("-0.25 rad"_unit == -0.25_rad, "");
+    static_assert("1.5e2 deg"_unit == 150.0_deg, "");
+    static_assert("  7 [Gy] "_unit == 7_Gy, "same format as operator<<");
+    static_assert("0.1 m"_unit == 0.1_m, "");
+
+    // Doesn't compile, unknown suffix or invalid number:
+    // constexpr auto x = "12.3 inch"_unit;
+    // constexpr auto y = "1.2.3 mm"_unit;
+  }
+#endif
+
   return true; // If this function compiled we are good!
 
 #if 0
@@ -248,6 +610,978 @@ bool Snippet3() {
   return true;
 }
 
+bool SerializeTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Single unit round-trip.
+  {
+    const auto my_mm = 12.3_mm;
+    unsigned char buf[thinks::serialized_size<decltype(my_mm)>(1)];
+    success &= thinks::serialize(my_mm, buf) == sizeof(buf);
+    success &= thinks::serialized_count(buf, sizeof(buf)) == 1;
+
+    auto x = thinks::Millimeters<double>{0.0};
+    success &= thinks::deserialize(buf, sizeof(buf), x) && x == my_mm;
+
+    // Wrong scale or value type is rejected and leaves output untouched.
+    auto y = thinks::Centimeters<double>{1.0};
+    success &= !thinks::deserialize(buf, sizeof(buf), y) && y == 1.0_cm;
+    auto z = thinks::Millimeters<float>{1.f};
+    success &= !thinks::deserialize(buf, sizeof(buf), z);
+
+    // Truncated buffer.
+    success &= !thinks::deserialize(buf, sizeof(buf) - 1, x);
+  }
+
+  // Span round-trip.
+  {
+    const std::vector<thinks::Gray<float>> doses = {
+        thinks::Gray<float>{0.5f}, thinks::Gray<float>{1.5f},
+        thinks::Gray<float>{-2.f}};
+    std::vector<unsigned char> buf(
+        thinks::serialized_size<thinks::Gray<float>>(doses.size()));
+    success &= thinks::serialize(doses.data(), doses.size(), buf.data()) ==
+               buf.size();
+
+    std::vector<thinks::Gray<float>> out(
+        thinks::serialized_count(buf.data(), buf.size()),
+        thinks::Gray<float>{0.f});
+    success &= out.size() == doses.size();
+    success &= thinks::deserialize(buf.data(), buf.size(), out.data(),
+                                   out.size());
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      success &= out[i] == doses[i];
+    }
+
+    // Values are little-endian after the header.
+    success &= buf[16 + 3] == 0x3f && buf[16 + 2] == 0x00;  // 0.5f
+
+    // Count mismatch.
+    success &= !thinks::deserialize(buf.data(), buf.size(), out.data(), 2);
+  }
+
+  return success;
+}
+
+bool ParseTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Scalar parsing, with and without brackets.
+  {
+    const std::string str = "123.5 [deg]";
+    auto x = thinks::Degrees<float>{0.f};
+    const auto r = thinks::from_chars(str.data(), str.data() + str.size(), x);
+    success &= r.ec == std::errc{} && r.ptr == str.data() + str.size();
+    success &= x == thinks::Degrees<float>{123.5f};
+
+    const std::string str2 = "-4 mm";
+    auto y = thinks::Millimeters<int>{0};
+    success &= thinks::from_chars(str2.data(), str2.data() + str2.size(), y)
+                       .ec == std::errc{} &&
+               y == -4_mm;
+  }
+
+  // Same-tag suffixes are converted, other tags are rejected.
+  {
+    const std::string str = "250 [cGy]";
+    auto x = thinks::Gray<double>{0.0};
+    success &= thinks::from_chars(str.data(), str.data() + str.size(), x)
+                       .ec == std::errc{} &&
+               x == 2.5_Gy;
+
+    const std::string bad = "250 [mm]";
+    const auto r = thinks::from_chars(bad.data(), bad.data() + bad.size(), x);
+    success &= r.ec == std::errc::invalid_argument && r.ptr == bad.data();
+    success &= x == 2.5_Gy;
+
+    const std::string unknown = "1.0 [inch]";
+    success &= thinks::from_chars(unknown.data(),
+                                  unknown.data() + unknown.size(), x)
+                   .ec == std::errc::invalid_argument;
+  }
+
+  // Multi-column line parsing.
+  {
+    const std::string str =
+        "90.5 [deg] 0.25 [Gy]\n"
+        "\n"
+        "  180 [deg]\t25 [cGy]\r\n"
+        "270 deg 1 Gy";
+    thinks::Degrees<float> gantry[4] = {0.f, 0.f, 0.f, 0.f};
+    thinks::Gray<float> dose[4] = {0.f, 0.f, 0.f, 0.f};
+    const auto r = thinks::parse_lines(str.data(), str.data() + str.size(), 4,
+                                       gantry, dose);
+    success &= r.ec == std::errc{} && r.count == 3 &&
+               r.ptr == str.data() + str.size();
+    success &= gantry[0] == thinks::Degrees<float>{90.5f} &&
+               gantry[1] == thinks::Degrees<float>{180.f} &&
+               gantry[2] == thinks::Degrees<float>{270.f};
+    success &= dose[0] == thinks::Gray<float>{0.25f} &&
+               dose[1] == thinks::Gray<float>{0.25f} &&
+               dose[2] == thinks::Gray<float>{1.f};
+
+    // Stops when columns are full.
+    const auto r2 = thinks::parse_lines(str.data(), str.data() + str.size(),
+                                        1, gantry, dose);
+    success &= r2.ec == std::errc{} && r2.count == 1 &&
+               r2.ptr == str.data() + str.find('\n') + 1;
+
+    // Reports the offending line.
+    const std::string bad = "1 [deg] 1 [Gy]\n2 [deg] 2 [mm]\n";
+    const auto r3 = thinks::parse_lines(bad.data(), bad.data() + bad.size(),
+                                        4, gantry, dose);
+    success &= r3.ec == std::errc::invalid_argument && r3.count == 1 &&
+               r3.ptr == bad.data() + bad.find('\n') + 1;
+  }
+
+  return success;
+}
+
+// Decimal comma and dot grouping, like de_DE, but always available.
+struct CommaNumpunct : std::numpunct<char> {
+  char do_decimal_point() const override { return ','; }
+  char do_thousands_sep() const override { return '.'; }
+  std::string do_grouping() const override { return "\3"; }
+};
+
+bool LocaleTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  const auto format_all = []() {
+    return thinks::to_string(12.3_mm) + ' ' + thinks::to_string(-1234567_cGy) +
+           ' ' + thinks::to_string(thinks::Degrees<float>{0.1f}) + ' ' +
+           thinks::to_string(thinks::Gray<double>{1e-20});
+  };
+  const std::string expected =
+      "12.3 [mm] -1234567 [cGy] 0.1 [deg] 1e-20 [Gy]";
+  success &= format_all() == expected;
+
+  // Stream formatting follows the locale.
+  {
+    std::ostringstream oss;
+    oss.imbue(std::locale(std::locale::classic(), new CommaNumpunct));
+    oss << 1234.5_mm;
+    success &= oss.str() == "1.234,5 [mm]";
+  }
+
+  // to_chars/from_chars ignore hostile global locales, both the C++ and 
+  // the C level ones.
+  const auto old_cpp_locale = std::locale::global(
+      std::locale(std::locale::classic(), new CommaNumpunct));
+  const std::string old_c_locale = std::setlocale(LC_ALL, nullptr);
+  for (const char* name : {"de_DE.UTF-8", "de_DE", "fr_FR.UTF-8"}) {
+    if (std::setlocale(LC_ALL, name) != nullptr) {
+      break;
+    }
+  }
+  {
+    success &= format_all() == expected;
+
+    const std::string str = "1234.5 [mm]";
+    auto x = thinks::Millimeters<double>{0.0};
+    success &= thinks::from_chars(str.data(), str.data() + str.size(), x)
+                       .ec == std::errc{} &&
+               x == 1234.5_mm;
+  }
+  std::setlocale(LC_ALL, old_c_locale.c_str());
+  std::locale::global(old_cpp_locale);
+
+  // Round-trip.
+  {
+    const auto x = thinks::Radians<double>{0.1 + 0.2};
+    const auto str = thinks::to_string(x);
+    auto y = thinks::Radians<double>{0.0};
+    success &= thinks::from_chars(str.data(), str.data() + str.size(), y)
+                       .ec == std::errc{} &&
+               y == x;
+  }
+
+  // Too small buffer.
+  {
+    char buf[8];
+    success &= thinks::to_chars(buf, buf + sizeof(buf), 12.3_mm).ec ==
+               std::errc::value_too_large;
+  }
+
+  return success;
+}
+
+bool DeltaCodecTests() {
+  auto success = true;
+
+  // Slowly varying values with occasional large jumps, including the
+  // extremes of the value type.
+  std::vector<thinks::Degrees<std::int32_t>> angles;
+  for (std::int32_t i = 0; i < 1000; ++i) {
+    angles.push_back(thinks::Degrees<std::int32_t>{(i * 3) % 360 - 180});
+  }
+  angles.push_back(thinks::Degrees<std::int32_t>{INT32_MAX});
+  angles.push_back(thinks::Degrees<std::int32_t>{INT32_MIN});
+  angles.push_back(thinks::Degrees<std::int32_t>{0});
+
+  using EncoderT = thinks::DeltaEncoder<thinks::Degrees<std::int32_t>>;
+  using DecoderT = thinks::DeltaDecoder<thinks::Degrees<std::int32_t>>;
+  std::vector<unsigned char> buf(
+      EncoderT::kHeaderSize + EncoderT::max_encoded_size(angles.size()));
+  std::size_t size = 0;
+  {
+    // Encode in two chunks.
+    EncoderT encoder;
+    size += encoder.write_header(buf.data());
+    size += encoder.encode(angles.data(), 500, buf.data() + size);
+    size += encoder.encode(angles.data() + 500, angles.size() - 500,
+                           buf.data() + size);
+  }
+  // Small deltas use a single byte.
+  success &= size < EncoderT::kHeaderSize + angles.size() + 32;
+
+  // Decode everything at once.
+  {
+    std::vector<thinks::Degrees<std::int32_t>> out(angles.size(), 0);
+    DecoderT decoder;
+    success &= decoder.read_header(buf.data(), size);
+    const auto r = decoder.decode(buf.data() + DecoderT::kHeaderSize,
+                                  size - DecoderT::kHeaderSize, out.data(),
+                                  out.size());
+    success &= r.ec == std::errc{} && r.count == angles.size() &&
+               r.ptr == buf.data() + size;
+    for (std::size_t i = 0; i < angles.size(); ++i) {
+      success &= out[i] == angles[i];
+    }
+  }
+
+  // Decode from input that arrives a few bytes at a time.
+  {
+    std::vector<thinks::Degrees<std::int32_t>> out(angles.size(), 0);
+    DecoderT decoder;
+    const unsigned char* p = buf.data() + DecoderT::kHeaderSize;
+    const unsigned char* const end = buf.data() + size;
+    std::size_t count = 0;
+    const unsigned char* avail = p;
+    while (count < out.size() && avail != end) {
+      avail = std::min(avail + 3, end);
+      const auto r = decoder.decode(p, static_cast<std::size_t>(avail - p),
+                                    out.data() + count, out.size() - count);
+      success &= r.ec == std::errc{};
+      count += r.count;
+      p = r.ptr;
+    }
+    success &= count == angles.size();
+    for (std::size_t i = 0; i < angles.size(); ++i) {
+      success &= out[i] == angles[i];
+    }
+  }
+
+  // Wrong unit.
+  {
+    thinks::DeltaDecoder<thinks::Millimeters<std::int32_t>> decoder;
+    success &= !decoder.read_header(buf.data(), size);
+  }
+
+  // Overlong varint.
+  {
+    const unsigned char bad[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    thinks::Degrees<std::int32_t> out[1] = {0};
+    DecoderT decoder;
+    success &= decoder.decode(bad, sizeof(bad), out, 1).ec ==
+               std::errc::invalid_argument;
+  }
+
+  // Last byte with payload bits beyond the value type.
+  {
+    const unsigned char max32[] = {0xff, 0xff, 0xff, 0xff, 0x0f};
+    const unsigned char bad32[] = {0xff, 0xff, 0xff, 0xff, 0x7f};
+    thinks::Degrees<std::int32_t> out32[1] = {0};
+    DecoderT decoder;
+    const auto r = decoder.decode(max32, sizeof(max32), out32, 1);
+    success &= r.ec == std::errc{} && r.count == 1 &&
+               out32[0].value() == std::numeric_limits<std::int32_t>::min();
+    success &= DecoderT{}.decode(bad32, sizeof(bad32), out32, 1).ec ==
+               std::errc::invalid_argument;
+
+    const unsigned char max16[] = {0xff, 0xff, 0x03};
+    const unsigned char bad16[] = {0xff, 0xff, 0x04};
+    thinks::Degrees<std::int16_t> out16[1] = {
+        thinks::Degrees<std::int16_t>{std::int16_t{0}}};
+    using Decoder16T = thinks::DeltaDecoder<thinks::Degrees<std::int16_t>>;
+    success &= Decoder16T{}.decode(max16, sizeof(max16), out16, 1).ec ==
+               std::errc{};
+    success &= Decoder16T{}.decode(bad16, sizeof(bad16), out16, 1).ec ==
+               std::errc::invalid_argument;
+
+    const unsigned char max8[] = {0xff, 0x01};
+    const unsigned char bad8[] = {0xff, 0x02};
+    thinks::Degrees<std::int8_t> out8[1] = {
+        thinks::Degrees<std::int8_t>{std::int8_t{0}}};
+    using Decoder8T = thinks::DeltaDecoder<thinks::Degrees<std::int8_t>>;
+    success &= Decoder8T{}.decode(max8, sizeof(max8), out8, 1).ec ==
+               std::errc{};
+    success &= Decoder8T{}.decode(bad8, sizeof(bad8), out8, 1).ec ==
+               std::errc::invalid_argument;
+  }
+
+  return success;
+}
+
+bool UserTagTests() {
+  using namespace thinks::unit_literals;
+  using namespace user_literals;
+  auto success = true;
+
+  // Conversions, arithmetic and derived dimensions.
+  static_assert(2_kg == 2000_g, "");
+  static_assert(thinks::unit_cast<Kilograms<double>>(500_g) == 0.5_kg, "");
+  static_assert(thinks::unit_cast<thinks::Centimeters<double>>(
+                    Inches<double>{1.0}) == 2.54_cm,
+                "");
+  static_assert(std::is_same_v<decltype((2_Gy * 3_kg).value()), long long>,
+                "");
+  static_assert(2_Gy * 3_kg / 3_kg == 2_Gy, "");
+  static_assert(thinks::unit_fingerprint_v<Kilograms<float>> !=
+                    thinks::unit_fingerprint_v<Grams<float>>,
+                "");
+
+  // I/O.
+  success &= thinks::to_string(2_kg) == "2 [kg]";
+  success &= thinks::to_string(MonitorUnits<int>{150}) == "150 [MU]";
+  {
+    const auto x = Micrograms<double>{1.25};
+    std::ostringstream oss;
+    oss << x;
+    const auto str = thinks::to_string(x);
+    success &= str.size() > 128 && str == oss.str();
+  }
+  {
+    const std::string str = "500 [g]";
+    auto x = Kilograms<double>{0.0};
+    success &= thinks::from_chars(str.data(), str.data() + str.size(), x)
+                       .ec == std::errc{} &&
+               x == 0.5_kg;
+
+    const std::string inches = "10 in";
+    auto y = thinks::Centimeters<double>{0.0};
+    success &= thinks::from_chars(inches.data(),
+                                  inches.data() + inches.size(), y)
+                       .ec == std::errc{} &&
+               y == 25.4_cm;
+  }
+  {
+    const std::string str = "100 [MU] 2 [Gy]\n";
+    MonitorUnits<float> mu[1] = {0.f};
+    thinks::Gray<float> dose[1] = {0.f};
+    const auto r = thinks::parse_lines(str.data(), str.data() + str.size(), 1,
+                                       mu, dose);
+    success &= r.count == 1 && mu[0] == 100_MU && dose[0] == 2_Gy;
+  }
+
+#if (__cplusplus >= 202002L) && defined(__cpp_nontype_template_args) && \
+    (__cpp_nontype_template_args >= 201911L)
+  static_assert("3 kg"_unit == 3000_g, "");
+  static_assert("12.5 MU"_unit == 12.5_MU, "");
+  static_assert("1 in"_unit == 2.54_cm, "");
+#endif
+
+  return success;
+}
+
+bool CommonUnitTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Each operand is converted once into the common unit.
+  const auto d = thinks::hypot(3_cm, 40_mm);
+  static_assert(
+      std::is_same_v<std::remove_const_t<decltype(d)>,
+                     thinks::Millimeters<double>>,
+      "");
+  success &= d == 50_mm;
+  success &= thinks::hypot(2_cm, 30_mm, 60_mm) == 7_cm;
+
+  // Typical use, clamping values in a loop without repeated casts.
+  const auto lo = thinks::Gray<float>{0.5F};
+  const auto hi = thinks::CentiGray<float>{150.F};
+  std::vector<thinks::CentiGray<float>> doses = {
+      thinks::CentiGray<float>{10.F}, thinks::CentiGray<float>{100.F},
+      thinks::CentiGray<float>{200.F}};
+  for (auto& dose : doses) {
+    dose = thinks::clamp(dose, lo, hi);
+  }
+  success &= doses[0] == 0.5_Gy && doses[1] == 1_Gy && doses[2] == 1.5_Gy;
+
+  return success;
+}
+
+bool AtomicTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Operands with other scales are converted to the scale of the atomic.
+  auto a = thinks::AtomicUnit<thinks::Gray<float>>{};
+  success &= a.fetch_add(thinks::CentiGray<float>{50.F}) == 0_Gy;
+  success &= (a += 1_Gy) == 1.5_Gy;
+  success &= a.fetch_sub(thinks::CentiGray<float>{25.F}) == 1.5_Gy;
+  success &= a.load() == 1.25_Gy;
+  auto expected = thinks::Gray<float>{1.25F};
+  success &= a.compare_exchange_strong(expected, thinks::Gray<float>{2.F}) && a.load() == 2_Gy;
+  success &= !a.compare_exchange_strong(expected, thinks::Gray<float>{3.F}) && expected == 2_Gy;
+
+  // Concurrent deposition, integer values make the result exact.
+  constexpr int kThreads = 4;
+  constexpr int kCount = 10000;
+  auto total = thinks::AtomicUnit<thinks::Millimeters<std::int64_t>>{};
+  auto total_f = thinks::AtomicUnit<thinks::Millimeters<double>>{};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kCount; ++i) {
+        total.fetch_add(1_cm, std::memory_order_relaxed);
+        total_f += 1_mm;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  success &= total.load() == thinks::Centimeters<int>{kThreads * kCount};
+  success &= total_f.load() == thinks::Millimeters<int>{kThreads * kCount};
+
+#if defined(__cpp_lib_atomic_ref)
+  // Atomic updates of plain units, e.g. voxels in a grid.
+  std::vector<thinks::Gray<double>> grid(4, thinks::Gray<double>{0.0});
+  threads.clear();
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kCount; ++i) {
+        thinks::AtomicUnitRef<thinks::Gray<double>>{grid[i % grid.size()]}
+            .fetch_add(thinks::CentiGray<int>{1});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& voxel : grid) {
+    success &= std::abs(voxel.value() - kThreads * kCount / 400.0) < 1e-9;
+  }
+#endif
+
+  return success;
+}
+
+bool ParallelTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Small grain size such that the values are split over several threads.
+  auto policy = thinks::execution::par;
+  policy.thread_count = 4;
+  policy.grain_size = 16;
+
+  std::vector<thinks::Millimeters<int>> lengths;
+  for (int i = 1; i <= 1001; ++i) {
+    lengths.push_back(thinks::Millimeters<int>{i % 2 == 0 ? i : -i});
+  }
+  const auto* p = lengths.data();
+  const auto n = lengths.size();
+  success &= thinks::sum(p, n) == thinks::Millimeters<int>{-501};
+  success &= thinks::sum(policy, p, n) == thinks::Millimeters<int>{-501};
+  success &= thinks::sum(p, 0) == 0_mm;
+  success &= thinks::min(policy, p, n) == -1001_mm;
+  success &= thinks::max(policy, p, n) == 1000_mm;
+  success &= thinks::minmax(p, n) == std::make_pair(thinks::Millimeters<int>{-1001}, 
+                                                   thinks::Millimeters<int>{1000});
+  success &= std::abs(thinks::mean(policy, p, n).value() + 501.0 / 1001) < 1e-12;
+
+  // Promotion follows operator+.
+  std::vector<thinks::Gray<std::int8_t>> small(300, thinks::Gray<std::int8_t>{1});
+  static_assert(std::is_same_v<decltype(thinks::sum(small.data(), 0)), 
+                               thinks::Gray<int>>, "");
+  success &= thinks::sum(policy, small.data(), small.size()) == thinks::Gray<int>{300};
+
+  // Custom operation, initial value in a different scale.
+  const auto r = thinks::reduce(
+      policy, p, n, thinks::Centimeters<double>{1.0},
+      [](const auto a, const auto b) { 
+        return a + thinks::unit_cast<thinks::Centimeters<double>>(b); 
+      });
+  success &= std::abs(r.value() - (1.0 - 50.1)) < 1e-9;
+
+  // Reproducible sums are bitwise identical for any number of threads.
+  std::vector<thinks::Gray<float>> doses;
+  auto x = 0.1F;
+  for (int i = 0; i < 50000; ++i) {
+    x = x * 3.9F * (1.F - x);  // Logistic map, values in (0, 1).
+    doses.push_back(thinks::Gray<float>{x * (i % 7 == 0 ? 1e4F : 1e-2F)});
+  }
+  const auto expected = 
+      thinks::reproducible_sum(doses.data(), doses.size()).value();
+  for (unsigned thread_count = 1; thread_count <= 8; ++thread_count) {
+    policy.thread_count = thread_count;
+    const auto actual = 
+        thinks::reproducible_sum(policy, doses.data(), doses.size()).value();
+    success &= std::memcmp(&actual, &expected, sizeof(float)) == 0;
+  }
+
+  return success;
+}
+
+bool GridTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Batch conversion.
+  const std::vector<thinks::CentiGray<int>> cgy = {
+      thinks::CentiGray<int>{50}, thinks::CentiGray<int>{150}, 
+      thinks::CentiGray<int>{-25}};
+  std::vector<thinks::Gray<double>> gy(cgy.size(), thinks::Gray<double>{0.0});
+  thinks::unit_cast(cgy.data(), cgy.size(), gy.data());
+  success &= gy[0] == 0.5_Gy && gy[1] == 1.5_Gy && gy[2] == -0.25_Gy;
+
+  // Centigray tallies from several threads, merged into a gray grid.
+  constexpr unsigned kThreads = 4;
+  constexpr std::size_t kVoxels = 1000;
+  auto grid = thinks::PrivatizedGrid<thinks::CentiGray<float>>(
+      kVoxels, kThreads, /*tile_size=*/64);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&grid, t]() {
+      // Each thread touches the voxels in [0, 500) and one voxel at
+      // the end of the grid.
+      for (std::size_t i = 0; i < kVoxels / 2; ++i) {
+        grid.add(t, i, thinks::CentiGray<float>{1.F});
+      }
+      grid.add(t, kVoxels - 1, thinks::Gray<float>{1.F});
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // 8 tiles of 64 voxels cover [0, 512), plus the last tile.
+  success &= grid.allocated_tile_count() == kThreads * 9;
+
+  auto policy = thinks::execution::par;
+  policy.grain_size = 64;
+  std::vector<thinks::Gray<float>> out(kVoxels, thinks::Gray<float>{1.F});
+  grid.merge(policy, out.data());
+  for (std::size_t i = 0; i < kVoxels; ++i) {
+    const auto expected = 
+        i < kVoxels / 2 ? 1.04F : (i == kVoxels - 1 ? 5.F : 1.F);
+    success &= std::abs(out[i].value() - expected) < 1e-6F;
+  }
+
+  grid.clear();
+  success &= grid.allocated_tile_count() == 0;
+
+  return success;
+}
+
+bool RingBufferTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Capacity is rounded up to a power of two.
+  auto spsc = thinks::SpscRingBuffer<thinks::Degrees<float>>(3);
+  success &= spsc.capacity() == 4;
+  const thinks::Degrees<float> in[] = {
+      thinks::Degrees<float>{1.F}, thinks::Degrees<float>{2.F},
+      thinks::Degrees<float>{3.F}, thinks::Degrees<float>{4.F},
+      thinks::Degrees<float>{5.F}};
+  success &= spsc.push(in, 5) == 4;
+  success &= !spsc.try_push(thinks::Degrees<float>{6.F});
+  auto out = thinks::Degrees<float>{0.F};
+  success &= spsc.try_pop(out) && out == 1_deg;
+  success &= spsc.try_push(thinks::Degrees<float>{6.F});
+  std::vector<thinks::Degrees<float>> popped(8, thinks::Degrees<float>{0.F});
+  success &= spsc.pop(popped.data(), popped.size()) == 4;
+  success &= popped[0] == 2_deg && popped[3] == 6_deg;
+  success &= !spsc.try_pop(out);
+
+  // Concurrent producers, values from each producer arrive in order.
+  constexpr int kProducers = 3;
+  constexpr int kCount = 20000;
+  auto mpsc = thinks::MpscRingBuffer<thinks::Millimeters<int>>(64);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&mpsc, p]() {
+      for (int i = 0; i < kCount; ++i) {
+        while (!mpsc.try_push(thinks::Millimeters<int>{p * kCount + i})) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<int> next(kProducers, 0);
+  std::vector<thinks::Millimeters<int>> batch(16, thinks::Millimeters<int>{0});
+  for (int received = 0; received < kProducers * kCount;) {
+    const auto n = mpsc.pop(batch.data(), batch.size());
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto v = batch[i].value();
+      success &= v % kCount == next[v / kCount]++;
+    }
+    received += static_cast<int>(n);
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  success &= !mpsc.try_pop(batch[0]);
+
+  return success;
+}
+
+bool ThreadPoolTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Every task runs exactly once, also for nested calls.
+  thinks::ThreadPool pool(3);
+  success &= pool.concurrency() == 4;
+  std::vector<std::atomic<int>> counts(1000);
+  pool.run(counts.size(), [&](const std::size_t k) {
+    counts[k].fetch_add(1);
+    if (k % 100 == 0) {
+      pool.run(10, [&](const std::size_t) { counts[k].fetch_add(1); });
+    }
+  });
+  for (std::size_t k = 0; k < counts.size(); ++k) {
+    success &= counts[k].load() == (k % 100 == 0 ? 11 : 1);
+  }
+
+  // Range algorithms on a caller-provided executor.
+  auto policy = thinks::execution::par;
+  policy.grain_size = 16;
+  policy.executor = pool;
+  std::vector<thinks::CentiGray<int>> cgy;
+  for (int i = 0; i < 10000; ++i) {
+    cgy.push_back(thinks::CentiGray<int>{int{i}});
+  }
+  std::vector<thinks::Gray<double>> gy(cgy.size(), thinks::Gray<double>{0.0});
+  thinks::unit_cast(policy, cgy.data(), cgy.size(), gy.data());
+  success &= gy[1234] == 12.34_Gy;
+  success &= thinks::sum(policy, cgy.data(), cgy.size()) == 
+             thinks::CentiGray<int>{9999 * 10000 / 2};
+  success &= thinks::max(policy, gy.data(), gy.size()) == 99.99_Gy;
+  success &= thinks::reproducible_sum(policy, gy.data(), gy.size()).value() ==
+             thinks::reproducible_sum(gy.data(), gy.size()).value();
+
+  // Exceptions thrown by tasks on any thread propagate to the caller
+  // after all tasks have finished, and the pool remains usable.
+  const auto throwing_op = [](const thinks::CentiGray<int> a,
+                              const thinks::CentiGray<int> b) {
+    if (b.value() % 1000 == 999) {
+      throw std::runtime_error("bad dose");
+    }
+    return a + b;
+  };
+  for (int i = 0; i < 10; ++i) {
+    try {
+      (void)thinks::reduce(policy, cgy.data(), cgy.size(),
+                           thinks::CentiGray<int>{0}, throwing_op);
+      success = false;
+    } catch (const std::runtime_error&) {
+    }
+  }
+  success &= thinks::sum(policy, cgy.data(), cgy.size()) ==
+             thinks::CentiGray<int>{9999 * 10000 / 2};
+
+  return success;
+}
+
+bool StatisticsTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Mean and standard deviation in the unit, variance in the squared
+  // unit.
+  using Stats = thinks::RunningStats<thinks::Millimeters<double>>;
+  static_assert(std::is_same_v<Stats::VarianceType,
+                               thinks::SquareMillimeters<double>>);
+  Stats stats;
+  for (const auto mm : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0}) {
+    stats.push(thinks::Millimeters<double>{double{mm}});
+  }
+  success &= stats.count() == 8 && stats.mean() == 5_mm;
+  success &= stats.variance() == thinks::SquareMillimeters<double>{4.0};
+  success &= stats.stddev() == 2_mm;
+  success &= std::abs(stats.sample_variance().value() - 32.0 / 7.0) < 1e-12;
+  success &= stats.min() == 2_mm && stats.max() == 9_mm;
+
+  // Batch push, per-thread partials and policies agree with scalar
+  // pushes. Integer values are accumulated in double precision.
+  std::vector<thinks::CentiGray<int>> cgy;
+  for (int i = 0; i < 10007; ++i) {
+    cgy.push_back(thinks::CentiGray<int>{int{(i * 37) % 1001 - 500}});
+  }
+  thinks::RunningStats<thinks::CentiGray<int>> scalar;
+  for (const auto v : cgy) {
+    scalar.push(v);
+  }
+  thinks::RunningStats<thinks::CentiGray<int>> batch;
+  batch.push(cgy.data(), cgy.size());
+  thinks::RunningStats<thinks::CentiGray<int>> lo;
+  thinks::RunningStats<thinks::CentiGray<int>> hi;
+  lo.push(cgy.data(), 3000);
+  hi.push(cgy.data() + 3000, cgy.size() - 3000);
+  lo.merge(hi);
+  auto policy = thinks::execution::par;
+  policy.grain_size = 100;
+  thinks::RunningStats<thinks::CentiGray<int>> parallel;
+  parallel.push(policy, cgy.data(), cgy.size());
+  for (const auto& s : {batch, lo, parallel}) {
+    success &= s.count() == scalar.count();
+    success &= std::abs(s.mean().value() - scalar.mean().value()) < 1e-9;
+    success &= std::abs(s.variance().value() - scalar.variance().value()) <
+               1e-9 * scalar.variance().value();
+    success &= s.min() == scalar.min() && s.max() == scalar.max();
+  }
+  success &= scalar.min() == thinks::CentiGray<int>{-500} &&
+             scalar.max() == thinks::CentiGray<int>{500};
+
+  // Quantiles of small streams are exact, minimum and maximum are
+  // always exact.
+  thinks::QuantileSketch<thinks::Degrees<float>> small;
+  for (const auto deg : {3.F, 1.F, 5.F, 2.F, 4.F}) {
+    small.push(thinks::Degrees<float>{float{deg}});
+  }
+  success &= small.quantile(0.5) == thinks::Degrees<float>{3.F};
+  success &= small.quantile(0.0) == thinks::Degrees<float>{1.F} &&
+             small.quantile(1.0) == thinks::Degrees<float>{5.F};
+
+  // Rank error of large streams is bounded, in particular for the tail
+  // quantiles. Sketches of parts of the stream are merged.
+  constexpr int kValues = 100000;
+  std::vector<thinks::Degrees<double>> errors;
+  for (int i = 0; i < kValues; ++i) {
+    errors.push_back(
+        thinks::Degrees<double>{double{((i * 7919) % kValues) * 0.001}});
+  }
+  thinks::QuantileSketch<thinks::Degrees<double>> whole;
+  whole.push(errors.data(), errors.size());
+  thinks::QuantileSketch<thinks::Degrees<double>> merged;
+  thinks::QuantileSketch<thinks::Degrees<double>> part;
+  merged.push(errors.data(), kValues / 3);
+  part.push(errors.data() + kValues / 3, kValues - kValues / 3);
+  merged.merge(part);
+  thinks::QuantileSketch<thinks::Degrees<double>> parallel_sketch;
+  parallel_sketch.push(policy, errors.data(), errors.size());
+  for (auto* sketch : {&whole, &merged, &parallel_sketch}) {
+    success &= sketch->count() == errors.size();
+    success &= sketch->centroid_count() <= sketch->compression();
+    // Value i * 0.001 has rank i.
+    success &= std::abs(sketch->quantile(0.5).value() - 50.0) < 0.1;
+    success &= std::abs(sketch->quantile(0.99).value() - 99.0) < 0.02;
+    success &= sketch->max() == thinks::Degrees<double>{99.999};
+  }
+
+  // Merging empty statistics has no effect.
+  thinks::RunningStats<thinks::CentiGray<int>> empty;
+  lo.merge(empty);
+  empty.merge(lo);
+  success &= lo.count() == cgy.size() && empty.count() == cgy.size();
+  empty.clear();
+  success &= empty.empty() && empty.variance().value() == 0.0;
+
+  return success;
+}
+
+// Error in units in the last place of T, relative to a long double
+// reference value.
+template <typename T>
+long double UlpError(const T value, const long double reference) {
+  const auto r = static_cast<T>(reference);
+  const auto ulp =
+      std::nextafter(std::abs(r), std::numeric_limits<T>::infinity()) -
+      std::abs(r);
+  return std::abs(value - reference) / ulp;
+}
+
+// Long double sine and cosine of an angle in degrees, reduced exactly
+// to [-45, 45] degrees such that there is no cancellation near zeros.
+std::pair<long double, long double> DegreeReference(const long double deg) {
+  constexpr long double kDegree = 3.141592653589793238462643383279503L / 180;
+  const auto r = std::remainder(deg, 90.0L);
+  const auto q = static_cast<long long>(std::round((deg - r) / 90)) & 3;
+  const auto s = std::sin(r * kDegree);
+  const auto c = std::cos(r * kDegree);
+  switch (q) {
+    case 0:
+      return {s, c};
+    case 1:
+      return {c, -s};
+    case 2:
+      return {-s, -c};
+    default:
+      return {-c, s};
+  }
+}
+
+bool TrigTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Multiples of 90 degrees are exact, also for integer angles.
+  success &= thinks::sin(90.0_deg) == 1.0 && thinks::cos(180.0_deg) == -1.0;
+  success &= thinks::cos(thinks::Degrees<float>{90.F}) == 0.F;
+  success &= thinks::sin(thinks::Degrees<int>{270}) == -1.0;
+  success &= thinks::sin(thinks::Degrees<double>{-720.0}) == 0.0;
+  static_assert(std::is_same_v<decltype(thinks::cos(30_deg)), double>);
+  const auto [s30, c30] = thinks::sincos(thinks::Degrees<float>{30.F});
+  success &= std::abs(s30 - 0.5F) < 1e-7F;
+  success &= std::abs(c30 - 0.8660254F) < 1e-7F;
+
+  // Error less than 2 ulp, batch and scalar functions agree. Angles
+  // cover the fast path, up to 4096 quarter turns (368640 degrees or
+  // about 6434 radians), with quadratic spacing for dense small angles.
+  constexpr int kCount = 20001;
+  std::vector<thinks::Degrees<float>> deg_f;
+  std::vector<thinks::Radians<float>> rad_f;
+  std::vector<thinks::Degrees<double>> deg_d;
+  std::vector<thinks::Radians<double>> rad_d;
+  for (int i = -kCount / 2; i <= kCount / 2; ++i) {
+    const auto t = i * std::abs(i);
+    deg_f.push_back(thinks::Degrees<float>{float{t * 3.68631e-3F}});
+    rad_f.push_back(thinks::Radians<float>{float{t * 6.43397e-5F}});
+    deg_d.push_back(thinks::Degrees<double>{double{t * 3.68631e-3}});
+    rad_d.push_back(thinks::Radians<double>{double{t * 6.43397e-5}});
+  }
+  // Worst case of a float reduction of radians.
+  rad_f.back() = thinks::Radians<float>{4292.86133F};
+  std::vector<float> sin_f(kCount);
+  std::vector<float> cos_f(kCount);
+  std::vector<double> sin_d(kCount);
+  std::vector<double> cos_d(kCount);
+  thinks::sincos(deg_f.data(), deg_f.size(), sin_f.data(), cos_f.data());
+  for (int i = 0; i < kCount; ++i) {
+    const auto [s, c] = DegreeReference(deg_f[i].value());
+    success &= UlpError(sin_f[i], s) < 2 && UlpError(cos_f[i], c) < 2;
+    success &= sin_f[i] == thinks::sin(deg_f[i]);
+  }
+  thinks::sin(rad_f.data(), rad_f.size(), sin_f.data());
+  thinks::cos(rad_f.data(), rad_f.size(), cos_f.data());
+  for (int i = 0; i < kCount; ++i) {
+    const auto x = static_cast<long double>(rad_f[i].value());
+    success &= UlpError(sin_f[i], std::sin(x)) < 2;
+    success &= UlpError(cos_f[i], std::cos(x)) < 2;
+    success &= cos_f[i] == thinks::cos(rad_f[i]);
+  }
+  thinks::sincos(deg_d.data(), deg_d.size(), sin_d.data(), cos_d.data());
+  for (int i = 0; i < kCount; ++i) {
+    const auto [s, c] = DegreeReference(deg_d[i].value());
+    success &= UlpError(sin_d[i], s) < 2 && UlpError(cos_d[i], c) < 2;
+  }
+  thinks::sincos(rad_d.data(), rad_d.size(), sin_d.data(), cos_d.data());
+  for (int i = 0; i < kCount; ++i) {
+    const auto x = static_cast<long double>(rad_d[i].value());
+    success &= UlpError(sin_d[i], std::sin(x)) < 2;
+    success &= UlpError(cos_d[i], std::cos(x)) < 2;
+  }
+
+  // Large angles are reduced exactly in degrees, non-finite angles give
+  // NaN.
+  success &= thinks::sin(thinks::Degrees<double>{3.6e9 + 30.0}) ==
+             thinks::sin(30.0_deg);
+  success &= thinks::cos(thinks::Degrees<int>{360000000}) == 1.0;
+  success &= std::abs(thinks::sin(thinks::Radians<double>{1e6}) -
+                      std::sin(1e6)) < 1e-15;
+  success &= std::isnan(thinks::sin(thinks::Degrees<double>{
+      std::numeric_limits<double>::infinity()}));
+  success &= std::isnan(thinks::cos(
+      thinks::Radians<float>{std::numeric_limits<float>::quiet_NaN()}));
+
+  return success;
+}
+
+#if THINKS_UNITS_HAS_COROUTINES
+bool StreamTests() {
+  using namespace thinks::unit_literals;
+  auto success = true;
+
+  // Source of centigray values 0, 1, ..., 999 in chunks.
+  constexpr int kCount = 1000;
+  auto next = 0;
+  const auto source = [&next](thinks::CentiGray<int>* data,
+                              const std::size_t max_count) {
+    std::size_t n = 0;
+    for (; n < max_count && next < kCount; ++n) {
+      data[n] = thinks::CentiGray<int>{next++};
+    }
+    return n;
+  };
+  auto expected = 0;
+  auto chunks = 0;
+  for (const auto chunk : thinks::stream_cast<thinks::Gray<double>,
+                                              thinks::CentiGray<int>>(
+           source, /*chunk_size=*/64)) {
+    success &= chunk.size() <= 64;
+    for (const auto dose : chunk) {
+      success &= std::abs(dose.value() - expected++ / 100.0) < 1e-12;
+    }
+    ++chunks;
+  }
+  success &= expected == kCount && chunks == (kCount + 63) / 64;
+
+  // Chunks of the source type are yielded without copies, and the
+  // stream can be abandoned before the end.
+  next = 0;
+  for (const auto chunk :
+       thinks::stream_cast<thinks::CentiGray<int>>(source, 10)) {
+    success &= chunk.size() == 10 && chunk[9] == thinks::CentiGray<int>{9};
+    break;
+  }
+
+  // Raw values are interpreted in the scale of the target unit, errors
+  // in the source propagate to the consumer.
+  auto calls = 0;
+  const auto raw_source = [&calls](float* data, const std::size_t) {
+    if (++calls > 2) {
+      throw std::runtime_error("read error");
+    }
+    data[0] = 1.5F;
+    return std::size_t{1};
+  };
+  auto total = thinks::Gray<float>{0.F};
+  try {
+    for (const auto chunk : thinks::stream_cast<thinks::Gray<float>, float>(
+             raw_source, /*chunk_size=*/4)) {
+      total += chunk[0];
+    }
+    success = false;
+  } catch (const std::runtime_error&) {
+    success &= total == 3_Gy;
+  }
+
+  // A source that claims to have written more values than requested (or
+  // a negative count) ends the stream with an error, the values are
+  // never read.
+  for (const int bad_count : {5, -1}) {
+    calls = 0;
+    const auto bad_source = [&calls, bad_count](float* data,
+                                                 const std::size_t) {
+      data[0] = 1.5F;
+      return ++calls > 1 ? bad_count : 1;
+    };
+    total = thinks::Gray<float>{0.F};
+    try {
+      for (const auto chunk : thinks::stream_cast<thinks::Gray<float>, float>(
+               bad_source, /*chunk_size=*/4)) {
+        success &= chunk.size() == 1;
+        total += chunk[0];
+      }
+      success = false;
+    } catch (const std::length_error&) {
+      success &= total == 1.5_Gy;
+    }
+  }
+
+  return success;
+}
+#endif
+
 void MainFunc() {
   std::cout << __cplusplus << '\n';
 
@@ -257,6 +1591,22 @@ void MainFunc() {
   success &= Snippet1();
   success &= Snippet2();
   success &= Snippet3();
+  success &= SerializeTests();
+  success &= ParseTests();
+  success &= LocaleTests();
+  success &= DeltaCodecTests();
+  success &= UserTagTests();
+  success &= CommonUnitTests();
+  success &= AtomicTests();
+  success &= ParallelTests();
+  success &= GridTests();
+  success &= RingBufferTests();
+  success &= ThreadPoolTests();
+  success &= StatisticsTests();
+  success &= TrigTests();
+#if THINKS_UNITS_HAS_COROUTINES
+  success &= StreamTests();
+#endif
 
   if (!success) {
     throw std::runtime_error("test failed");
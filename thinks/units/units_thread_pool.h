@@ -0,0 +1,295 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Work-stealing thread pool used by the parallel algorithms.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+// Reference to an executor that runs the tasks of the parallel
+// algorithms, such that callers can provide their own scheduler. An
+// executor is any object with the member functions
+//
+//   // Number of threads that run tasks, including the calling thread.
+//   unsigned concurrency() const;
+//
+//   // Call task(k) for all k in [0, task_count), potentially
+//   // concurrently, and return when all calls have returned. If tasks
+//   // throw, one of the exceptions is rethrown.
+//   void run(std::size_t task_count,
+//            const std::function<void(std::size_t)>& task);
+//
+// NOTE(thinks):
+//   Type erasure with function pointers rather than a virtual base
+//   class, since the latter crashes some compilers when used through
+//   the thinks.units module (e.g. GCC 12). For the same reason an empty
+//   reference is used rather than std::optional.
+class ExecutorRef {
+ public:
+  // Empty reference, see operator bool.
+  constexpr ExecutorRef() noexcept = default;
+
+  template <typename ExecutorT,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::remove_cv_t<ExecutorT>, ExecutorRef>>>
+  /*implicit*/ constexpr ExecutorRef(ExecutorT& executor) noexcept
+      : executor_{&executor},
+        concurrency_{[](const void* e) {
+          return static_cast<const ExecutorT*>(e)->concurrency();
+        }},
+        run_{[](void* e, const std::size_t task_count,
+                const std::function<void(std::size_t)>& task) {
+          static_cast<ExecutorT*>(e)->run(task_count, task);
+        }} {}
+
+  NO_DISCARD constexpr explicit operator bool() const noexcept {
+    return executor_ != nullptr;
+  }
+
+  NO_DISCARD auto concurrency() const -> unsigned {
+    return concurrency_(executor_);
+  }
+
+  void run(const std::size_t task_count,
+           const std::function<void(std::size_t)>& task) const {
+    run_(executor_, task_count, task);
+  }
+
+ private:
+  void* executor_ = nullptr;
+  unsigned (*concurrency_)(const void*) = nullptr;
+  void (*run_)(void*, std::size_t,
+               const std::function<void(std::size_t)>&) = nullptr;
+};
+
+// Executor where each worker thread has its own queue of task ranges. A
+// worker splits the range it is working on in halves, pushing the upper
+// half onto its own queue, and idle workers steal the largest (oldest)
+// ranges from other queues. The thread calling run also executes tasks,
+// which makes nested calls to run safe. When a task throws, the
+// remaining tasks of the same run are skipped and run rethrows the first
+// exception once no thread refers to the job anymore.
+class ThreadPool {
+ public:
+  // Zero means one worker per hardware thread, excluding the calling
+  // thread.
+  explicit ThreadPool(unsigned worker_count = 0)
+      : queues_(worker_count == 0
+                    ? std::max(1U, std::thread::hardware_concurrency()) - 1
+                    : worker_count) {
+    workers_.reserve(queues_.size());
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  NO_DISCARD auto worker_count() const noexcept -> unsigned {
+    return static_cast<unsigned>(queues_.size());
+  }
+
+  NO_DISCARD auto concurrency() const noexcept -> unsigned {
+    return worker_count() + 1;
+  }
+
+  void run(const std::size_t task_count,
+           const std::function<void(std::size_t)>& task) {
+    if (task_count == 0) {
+      return;
+    }
+    if (queues_.empty() || task_count == 1) {
+      for (std::size_t k = 0; k < task_count; ++k) {
+        task(k);
+      }
+      return;
+    }
+
+    Job job;
+    job.task = &task;
+    job.remaining.store(task_count, std::memory_order_relaxed);
+    const auto q = HomeQueue();
+    Execute(Range{&job, 0, task_count}, q);
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+      Range range;
+      if (TryPop(q, range)) {
+        Execute(range, q);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    if (job.exception) {
+      std::rethrow_exception(job.exception);
+    }
+  }
+
+  // Pool shared by the parallel algorithms when the execution policy
+  // does not specify an executor.
+  NO_DISCARD static auto default_pool() -> ThreadPool& {
+    static ThreadPool pool;
+    return pool;
+  }
+
+ private:
+  struct Job {
+    const std::function<void(std::size_t)>* task = nullptr;
+    std::atomic<std::size_t> remaining{0};
+    // First exception thrown by a task, written once by the thread that
+    // sets failed and read by run when remaining is zero.
+    std::atomic<bool> failed{false};
+    std::exception_ptr exception;
+  };
+
+  // Tasks [begin, end) of a job.
+  struct Range {
+    Job* job = nullptr;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  // Index of the queue owned by the calling thread, threads that are
+  // not workers of this pool share the queues in round-robin order.
+  auto HomeQueue() noexcept -> std::size_t {
+    if (current_pool_ == this) {
+      return current_queue_;
+    }
+    return next_queue_.fetch_add(1, std::memory_order_relaxed) %
+           queues_.size();
+  }
+
+  void Push(const std::size_t q, const Range range) {
+    {
+      std::lock_guard<std::mutex> lock(queues_[q].mutex);
+      queues_[q].ranges.push_back(range);
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+    {
+      // Synchronize with workers that are about to sleep.
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  // Own queue first (most recently pushed, i.e. smallest range), then
+  // steal from the other queues (oldest, i.e. largest range).
+  auto TryPop(const std::size_t q, Range& range) -> bool {
+    if (queued_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queues_[q].mutex);
+      if (!queues_[q].ranges.empty()) {
+        range = queues_[q].ranges.back();
+        queues_[q].ranges.pop_back();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (std::size_t i = 1; i < queues_.size(); ++i) {
+      auto& victim = queues_[(q + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.ranges.empty()) {
+        range = victim.ranges.front();
+        victim.ranges.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Split off upper halves until a single task remains, then run it.
+  // Exceptions are caught on every thread, since the job lives on the
+  // stack of run and must outlive all queued ranges that refer to it.
+  void Execute(Range range, const std::size_t q) {
+    while (range.end - range.begin > 1) {
+      const auto mid = range.begin + (range.end - range.begin) / 2;
+      Push(q, Range{range.job, mid, range.end});
+      range.end = mid;
+    }
+    auto& job = *range.job;
+    if (!job.failed.load(std::memory_order_relaxed)) {
+      try {
+        (*job.task)(range.begin);
+      } catch (...) {
+        if (!job.failed.exchange(true, std::memory_order_relaxed)) {
+          job.exception = std::current_exception();
+        }
+      }
+    }
+    // The job may be destroyed as soon as remaining reaches zero.
+    job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void WorkerLoop(const std::size_t q) {
+    current_pool_ = this;
+    current_queue_ = q;
+    for (;;) {
+      Range range;
+      if (TryPop(q, range)) {
+        Execute(range, q);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this]() {
+        return stop_ || queued_.load(std::memory_order_acquire) > 0;
+      });
+      if (stop_) {
+        return;
+      }
+    }
+  }
+
+  static inline thread_local const ThreadPool* current_pool_ = nullptr;
+  static inline thread_local std::size_t current_queue_ = 0;
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> queued_{0};
+  std::atomic<std::size_t> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+#undef NO_DISCARD
+
+}  // namespace thinks
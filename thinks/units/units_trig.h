@@ -0,0 +1,358 @@
+// Copyright(C) Tommy Hinks <tommy.hinks@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// Trigonometric functions of angle units.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "thinks/units/units_core.h"
+
+#if (__cplusplus >= 201703L)
+  #define NO_DISCARD [[nodiscard]]
+#else
+  #define NO_DISCARD
+#endif
+
+namespace thinks {
+
+namespace units_internal {
+
+// Value type of trigonometric functions of angles, integer angles are
+// evaluated in double precision.
+template <typename ArithT>
+using TrigValueType = std::conditional_t<std::is_floating_point_v<ArithT>,
+                                         ArithT, double>;
+
+// The most significant bits of v, the remaining bits are zeroed.
+NO_DISCARD constexpr auto TruncateBits(const double v, const int bits) noexcept
+    -> double {
+  if (v == 0) {
+    return 0;
+  }
+  const double a = v < 0 ? -v : v;
+  const double lo = static_cast<double>(std::int64_t{1} << (bits - 1));
+  double scale = 1;
+  while (a * scale >= 2 * lo) {
+    scale /= 2;
+  }
+  while (a * scale < lo) {
+    scale *= 2;
+  }
+  const double t = static_cast<double>(static_cast<std::int64_t>(a * scale));
+  return (v < 0 ? -t : t) / scale;
+}
+
+// Sine and cosine of angles with the given scale, evaluated in FloatT
+// (float or double).
+//
+// The angle is reduced to r in [-Q/2, Q/2] in the scale of the angle,
+// where Q is a quarter turn, e.g. 90 degrees. Q is split into parts
+// such that the reduction is exact for degrees and, in double, accurate
+// for radians, as long as the angle is less than kMaxQuarterTurns
+// quarter turns (see TrigEvalType). The polynomials in r have the
+// radians per unit folded into their coefficients, such that degrees
+// are never converted to radians. Minimax coefficients from Cephes
+// (S. Moshier).
+template <typename FloatT, typename ScaleT>
+struct TrigKernel {
+  static_assert(std::is_same_v<FloatT, float> ||
+                    std::is_same_v<FloatT, double>,
+                "FloatT must be float or double");
+
+  using Helper = ScaleHelper<ScaleT, RadianScale>;
+  using RatioT = typename ScaleTraits<ScaleT>::RatioType;
+
+  // Radians per unit of the scale.
+  static constexpr DoubleDouble kRadians =
+      ScaleFactor<typename Helper::FromRatioT, typename Helper::ToRatioT,
+                  Helper::kPiExponent>();
+
+  // Quarter turn in units of the scale, rational unless the scale
+  // has a power of pi.
+  static constexpr DoubleDouble kQuarterTurn =
+      ScaleTraits<ScaleT>::pi_exponent == 0
+          ? Div(ToDoubleDouble(90 * RatioT::den), ToDoubleDouble(RatioT::num))
+          : Div(Mul(kPi, {0.5, 0.0}), kRadians);
+
+  // Q = kQ1 + kQ2 + kQ3 + kQ4, where n * kQ1, n * kQ2 and n * kQ3 are
+  // exact for n up to kMaxQuarterTurns.
+  static constexpr int kSplitBits = std::numeric_limits<FloatT>::digits - 12;
+  static constexpr FloatT kMaxQuarterTurns = 4096;
+  static constexpr double kQ1d = TruncateBits(kQuarterTurn.hi, kSplitBits);
+  static constexpr DoubleDouble kRest1 = Add(kQuarterTurn, {-kQ1d, 0.0});
+  static constexpr double kQ2d = TruncateBits(kRest1.hi, kSplitBits);
+  static constexpr DoubleDouble kRest2 = Add(kRest1, {-kQ2d, 0.0});
+  static constexpr double kQ3d = TruncateBits(kRest2.hi, kSplitBits);
+  static constexpr DoubleDouble kRest3 = Add(kRest2, {-kQ3d, 0.0});
+  static constexpr FloatT kQ1 = static_cast<FloatT>(kQ1d);
+  static constexpr FloatT kQ2 = static_cast<FloatT>(kQ2d);
+  static constexpr FloatT kQ3 = static_cast<FloatT>(kQ3d);
+  static constexpr FloatT kQ4 = RoundTo<FloatT>(kRest3);
+  static constexpr FloatT kInvQuarterTurn =
+      RoundTo<FloatT>(Div({1.0, 0.0}, kQuarterTurn));
+
+  // True if the quarter turn is exactly representable (e.g. degrees),
+  // such that angles can be reduced exactly with std::fmod.
+  static constexpr bool kExactQuarterTurn = kQ2 == 0 && kQ3 == 0 && kQ4 == 0;
+
+  // Adding and subtracting rounds to an integer.
+  static constexpr FloatT kRound = static_cast<FloatT>(
+      std::int64_t{3} << (std::numeric_limits<FloatT>::digits - 2));
+
+  // Cephes coefficients of x^(2k+1) and x^(2k) for |x| <= pi/4.
+  static constexpr std::size_t kSinCount =
+      std::is_same_v<FloatT, float> ? 4 : 7;
+  static constexpr std::size_t kCosCount =
+      std::is_same_v<FloatT, float> ? 5 : 8;
+  static constexpr double kSinCoefficients[2][7] = {
+      {1.0, -1.6666654611E-1, 8.3321608736E-3, -1.9515295891E-4},
+      {1.0, -1.66666666666666307295E-1, 8.33333333332211858878E-3,
+       -1.98412698295895385996E-4, 2.75573136213857245213E-6,
+       -2.50507477628578072866E-8, 1.58962301576546568060E-10}};
+  static constexpr double kCosCoefficients[2][8] = {
+      {1.0, -0.5, 4.166664568298827E-2, -1.388731625493765E-3,
+       2.443315711809948E-5},
+      {1.0, -0.5, 4.16666666666665929218E-2, -1.38888888888730564116E-3,
+       2.48015872888517045348E-5, -2.75573141792967388112E-7,
+       2.08757008419747316778E-9, -1.13585365213876817300E-11}};
+
+  // c * kRadians^power, rounded to FloatT.
+  NO_DISCARD static constexpr auto Fold(const double c, const int power)
+      noexcept -> FloatT {
+    DoubleDouble f = {c, 0.0};
+    for (int i = 0; i < power; ++i) {
+      f = Mul(f, kRadians);
+    }
+    return RoundTo<FloatT>(f);
+  }
+
+  struct Polynomials {
+    FloatT sin[kSinCount];
+    FloatT cos[kCosCount];
+  };
+  NO_DISCARD static constexpr auto MakePolynomials() noexcept -> Polynomials {
+    constexpr std::size_t kRow = std::is_same_v<FloatT, float> ? 0 : 1;
+    Polynomials p = {};
+    for (std::size_t k = 0; k < kSinCount; ++k) {
+      p.sin[k] =
+          Fold(kSinCoefficients[kRow][k], static_cast<int>(2 * k + 1));
+    }
+    for (std::size_t k = 0; k < kCosCount; ++k) {
+      p.cos[k] = Fold(kCosCoefficients[kRow][k], static_cast<int>(2 * k));
+    }
+    return p;
+  }
+  static constexpr Polynomials kPolynomials = MakePolynomials();
+
+  // True if Eval is accurate for x, false for large or non-finite x.
+  NO_DISCARD static auto InRange(const FloatT x) noexcept -> bool {
+    const FloatT y = x * kInvQuarterTurn;
+    return y >= -kMaxQuarterTurns && y <= kMaxQuarterTurns;
+  }
+
+  // Branch-free, such that loops calling it can be vectorized. Results
+  // for angles that are not InRange are garbage.
+  static void Eval(const FloatT x, FloatT& sin_x, FloatT& cos_x) noexcept {
+    // The nearest number of quarter turns n, the two least significant
+    // bits of the shifted value are n mod 4. Reading the bits rather than
+    // converting to integer is defined also for large and NaN angles.
+    const FloatT shifted = x * kInvQuarterTurn + kRound;
+    const FloatT n = shifted - kRound;
+    std::conditional_t<std::is_same_v<FloatT, float>, std::uint32_t,
+                       std::uint64_t>
+        bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    const auto q = static_cast<std::int32_t>(bits & 3);
+    FloatT r = x - n * kQ1;
+    if constexpr (!kExactQuarterTurn) {
+      r = ((r - n * kQ2) - n * kQ3) - n * kQ4;
+    }
+    const FloatT z = r * r;
+
+    // The linear term is added last, such that its rounding dominates.
+    FloatT ps = kPolynomials.sin[kSinCount - 1];
+    for (std::size_t k = kSinCount - 1; k > 1; --k) {
+      ps = ps * z + kPolynomials.sin[k - 1];
+    }
+    ps = kPolynomials.sin[0] * r + (r * z) * ps;
+    FloatT pc = kPolynomials.cos[kCosCount - 1];
+    for (std::size_t k = kCosCount - 1; k > 0; --k) {
+      pc = pc * z + kPolynomials.cos[k - 1];
+    }
+
+    // Quadrant q mod 4: sin(x) is sin(r), cos(r), -sin(r), -cos(r) and
+    // cos(x) is cos(r), -sin(r), -cos(r), sin(r).
+    // NOTE(thinks):
+    //   Selected with (exact) multiplications by zero and one rather than
+    //   with conditionals, since compilers move the polynomials into
+    //   branches that they then fail to vectorize.
+    const auto odd = static_cast<FloatT>(q & 1);
+    const auto even = 1 - odd;
+    const auto sin_sign = 1 - static_cast<FloatT>(q & 2);
+    const auto cos_sign = 1 - static_cast<FloatT>((q + 1) & 2);
+    sin_x = sin_sign * (even * ps + odd * pc);
+    cos_x = cos_sign * (even * pc + odd * ps);
+  }
+
+  // Large and non-finite angles.
+  static void EvalSlow(const FloatT x, FloatT& sin_x, FloatT& cos_x) {
+    if constexpr (kExactQuarterTurn) {
+      Eval(std::fmod(x, 4 * kQ1), sin_x, cos_x);
+    } else {
+      const FloatT radians = x * RoundTo<FloatT>(kRadians);
+      sin_x = std::sin(radians);
+      cos_x = std::cos(radians);
+    }
+  }
+};
+
+// Precision in which the kernel evaluates angles with value type
+// FloatT. Float angles with an irrational quarter turn (e.g. radians) are
+// evaluated in double, since a float reduction of such angles is not
+// accurate to within 2 ulp.
+template <typename FloatT, typename ScaleT>
+using TrigEvalType =
+    std::conditional_t<TrigKernel<FloatT, ScaleT>::kExactQuarterTurn, FloatT,
+                       double>;
+
+// Write the sines and/or cosines of count angles, outputs may be null.
+template <typename ArithT, typename ScaleT>
+void SinCos(const Unit<ArithT, ScaleT, AngleTag>* angles,
+            const std::size_t count, TrigValueType<ArithT>* sin_out,
+            TrigValueType<ArithT>* cos_out) {
+  using FloatT = TrigValueType<ArithT>;
+  if constexpr (std::is_same_v<FloatT, long double>) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto radians =
+          ScaleHelper<ScaleT, RadianScale>::template Scale<FloatT>(
+              angles[i].value());
+      if (sin_out != nullptr) {
+        sin_out[i] = std::sin(radians);
+      }
+      if (cos_out != nullptr) {
+        cos_out[i] = std::cos(radians);
+      }
+    }
+  } else {
+    using EvalT = TrigEvalType<FloatT, ScaleT>;
+    using Kernel = TrigKernel<EvalT, ScaleT>;
+    const auto value = [angles](const std::size_t i) {
+      return static_cast<EvalT>(angles[i].value());
+    };
+    // Separate loops without null checks, such that they vectorize.
+    if (sin_out != nullptr && cos_out != nullptr) {
+      for (std::size_t i = 0; i < count; ++i) {
+        EvalT s;
+        EvalT c;
+        Kernel::Eval(value(i), s, c);
+        sin_out[i] = static_cast<FloatT>(s);
+        cos_out[i] = static_cast<FloatT>(c);
+      }
+    } else if (sin_out != nullptr) {
+      for (std::size_t i = 0; i < count; ++i) {
+        EvalT s;
+        EvalT c;
+        Kernel::Eval(value(i), s, c);
+        sin_out[i] = static_cast<FloatT>(s);
+      }
+    } else if (cos_out != nullptr) {
+      for (std::size_t i = 0; i < count; ++i) {
+        EvalT s;
+        EvalT c;
+        Kernel::Eval(value(i), s, c);
+        cos_out[i] = static_cast<FloatT>(c);
+      }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!Kernel::InRange(value(i))) {
+        EvalT s;
+        EvalT c;
+        Kernel::EvalSlow(value(i), s, c);
+        if (sin_out != nullptr) {
+          sin_out[i] = static_cast<FloatT>(s);
+        }
+        if (cos_out != nullptr) {
+          cos_out[i] = static_cast<FloatT>(c);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace units_internal
+
+// Sine and cosine of angles with any scale, e.g. degrees or radians.
+// Integer angles, and float angles in scales with a factor of pi (e.g.
+// radians), are evaluated in double precision.
+//
+// Degrees (and other scales without a factor of pi) are reduced
+// exactly, such that multiples of 90 degrees give exact zeros and
+// ones. Compared with std::sin and std::cos of the angle in radians
+// (computed in long double) the error is less than 2 ulp for float and
+// double angles up to 4096 quarter turns (measured at most 1.7 ulp).
+// Larger angles are reduced with std::fmod (degrees) or evaluated with
+// the standard library (radians). Long double angles are always
+// evaluated with the standard library.
+template <typename ArithT, typename ScaleT>
+NO_DISCARD auto sin(const Unit<ArithT, ScaleT, units_internal::AngleTag> angle)
+    -> units_internal::TrigValueType<ArithT> {
+  units_internal::TrigValueType<ArithT> s;
+  units_internal::SinCos(&angle, 1, &s, nullptr);
+  return s;
+}
+
+template <typename ArithT, typename ScaleT>
+NO_DISCARD auto cos(const Unit<ArithT, ScaleT, units_internal::AngleTag> angle)
+    -> units_internal::TrigValueType<ArithT> {
+  units_internal::TrigValueType<ArithT> c;
+  units_internal::SinCos(&angle, 1, nullptr, &c);
+  return c;
+}
+
+// Returns {sin(angle), cos(angle)}, in about the time of one of them.
+template <typename ArithT, typename ScaleT>
+NO_DISCARD auto sincos(
+    const Unit<ArithT, ScaleT, units_internal::AngleTag> angle)
+    -> std::pair<units_internal::TrigValueType<ArithT>,
+                 units_internal::TrigValueType<ArithT>> {
+  units_internal::TrigValueType<ArithT> s;
+  units_internal::TrigValueType<ArithT> c;
+  units_internal::SinCos(&angle, 1, &s, &c);
+  return {s, c};
+}
+
+// Sines and/or cosines of an array of angles, e.g. the gantry angles of
+// all control points. Same accuracy as the functions above, the inner
+// loops are branch-free such that the compiler can vectorize them.
+template <typename ArithT, typename ScaleT>
+void sin(const Unit<ArithT, ScaleT, units_internal::AngleTag>* angles,
+         const std::size_t count, units_internal::TrigValueType<ArithT>* out) {
+  units_internal::SinCos(angles, count, out, nullptr);
+}
+
+template <typename ArithT, typename ScaleT>
+void cos(const Unit<ArithT, ScaleT, units_internal::AngleTag>* angles,
+         const std::size_t count, units_internal::TrigValueType<ArithT>* out) {
+  units_internal::SinCos(angles, count, nullptr, out);
+}
+
+template <typename ArithT, typename ScaleT>
+void sincos(const Unit<ArithT, ScaleT, units_internal::AngleTag>* angles,
+            const std::size_t count,
+            units_internal::TrigValueType<ArithT>* sin_out,
+            units_internal::TrigValueType<ArithT>* cos_out) {
+  units_internal::SinCos(angles, count, sin_out, cos_out);
+}
+
+#undef NO_DISCARD
+
+}  // namespace thinks